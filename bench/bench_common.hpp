@@ -0,0 +1,82 @@
+#pragma once
+// Shared helpers for the benchmark executables: synthetic inputs, timing,
+// JSON-lines output and baseline comparison.
+#include "../src/chart.hpp"
+#include <nlohmann/json.hpp>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <string>
+
+// A chart of `seconds` length with roughly notesPerSec notes per second:
+// random strings/frets, mostly short notes with some sustains, slides and
+// technique tags, sorted by time like the loaders produce.
+inline Chart makeSyntheticChart(double notesPerSec, int seconds, uint32_t seed = 1) {
+  Chart c;
+  c.title = "Synthetic";
+  c.bpm = 120.0;
+  std::mt19937 rng(seed);
+  std::uniform_int_distribution<int> str(1, 6), fret(0, 24), pct(0, 99);
+  int count = (int)(notesPerSec * seconds);
+  c.notes.reserve(count);
+  double step = count ? seconds * 1000.0 / count : 0.0;
+  for (int i = 0; i < count; ++i) {
+    NoteEvent n{};
+    n.t_ms = (int64_t)(i * step);
+    n.str = str(rng);
+    n.fret = fret(rng);
+    n.len_ms = pct(rng) < 20 ? 400 + pct(rng) * 10 : 120;
+    if (pct(rng) < 10) n.slideTo = fret(rng);
+    if (pct(rng) < 10) n.techs.push_back("bend");
+    c.notes.push_back(n);
+  }
+  return c;
+}
+
+inline uint64_t benchNowNs() {
+  return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// One result per line, e.g.
+// {"bench":"render","case":"chart_1280x720_16nps","phase":"total","ns":123456.0}
+inline void emitResult(const char* bench, const std::string& name, const std::string& phase, double ns) {
+  nlohmann::json j;
+  j["bench"] = bench;
+  j["case"] = name;
+  j["phase"] = phase;
+  j["ns"] = ns;
+  std::printf("%s\n", j.dump().c_str());
+  std::fflush(stdout);
+}
+
+// Non-timing metrics: {"bench":..,"case":..,"metric":..,"value":..,"unit":..}
+inline void emitMetric(const char* bench, const std::string& name, const std::string& metric,
+                       double value, const char* unit) {
+  nlohmann::json j;
+  j["bench"] = bench;
+  j["case"] = name;
+  j["metric"] = metric;
+  j["value"] = value;
+  j["unit"] = unit;
+  std::printf("%s\n", j.dump().c_str());
+  std::fflush(stdout);
+}
+
+// Baseline files map case name -> ns for the "total" phase.
+inline nlohmann::json loadBaseline(const std::string& path) {
+  std::ifstream f(path);
+  if (!f) return nlohmann::json::object();
+  nlohmann::json j;
+  try { f >> j; } catch (const nlohmann::json::exception&) { return nlohmann::json::object(); }
+  return j.is_object() ? j : nlohmann::json::object();
+}
+
+inline bool saveBaseline(const std::string& path, const nlohmann::json& j) {
+  std::ofstream f(path);
+  if (!f) return false;
+  f << j.dump(2) << "\n";
+  return true;
+}
@@ -0,0 +1,159 @@
+#include "../src/chart.hpp"
+#include "../src/synth.hpp"
+#include "../src/pitch_detect.hpp"
+#include "bench_common.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+#include <numeric>
+#include <string_view>
+
+// Pitch-detection benchmark on synthesized audio. Each scenario renders a
+// chart with the Karplus-Strong synth and streams it hop by hop through
+// every detector, measuring
+//   - time from note onset to the first detection within 50 cents,
+//   - notes never detected while sounding,
+//   - false detections (pitched output matching no sounding note),
+//   - CPU time per hop.
+//
+//   detect_bench [--quick] [--noise dB] [--attack 0..1] [--hop N]
+
+static constexpr double kRate = 48000.0;
+static constexpr unsigned kWin = 2048;
+
+static double midiOf(double hz) { return 69.0 + 12.0 * std::log2(hz / 440.0); }
+
+// Single notes spread over the neck, one every 400 ms.
+static Chart melodyChart(int count, uint32_t seed) {
+  Chart c;
+  std::mt19937 rng(seed);
+  std::uniform_int_distribution<int> str(1, 6), fret(0, 15);
+  for (int i = 0; i < count; ++i) {
+    NoteEvent n{};
+    n.t_ms = 200 + i * 400;
+    n.str = str(rng);
+    n.fret = fret(rng);
+    n.len_ms = 300;
+    c.notes.push_back(n);
+  }
+  return c;
+}
+
+// Three-note power-chord shapes, one every 600 ms.
+static Chart chordChart(int count, uint32_t seed) {
+  Chart c;
+  std::mt19937 rng(seed);
+  std::uniform_int_distribution<int> root(0, 10);
+  for (int i = 0; i < count; ++i) {
+    int f = root(rng);
+    for (int k = 0; k < 3; ++k) {
+      NoteEvent n{};
+      n.t_ms = 200 + i * 600;
+      n.str = 6 - k;
+      n.fret = f + (k ? 2 : 0);
+      n.len_ms = 450;
+      c.notes.push_back(n);
+    }
+  }
+  return c;
+}
+
+struct DetectResult {
+  std::vector<double> latenciesMs;
+  int notes = 0;
+  int missed = 0;
+  int pitchedHops = 0;
+  int falseHops = 0;
+  double nsPerHop = 0.0;
+};
+
+static DetectResult runDetector(PitchDetector& det, const Chart& c, const std::vector<float>& pcm, unsigned hop) {
+  // Group notes by onset so a chord counts once and matches any member.
+  struct Group { int64_t t, end; std::vector<double> midis; bool found = false; };
+  std::vector<Group> groups;
+  for (const auto& n : c.notes) {
+    double midi = c.tuning[std::clamp(c.strings - n.str, 0, c.strings - 1)] + n.fret;
+    if (groups.empty() || groups.back().t != n.t_ms) groups.push_back(Group{n.t_ms, n.t_ms + n.len_ms, {}});
+    groups.back().midis.push_back(midi);
+  }
+
+  DetectResult r;
+  r.notes = (int)groups.size();
+  uint64_t ns = 0;
+  std::size_t hops = 0;
+  for (std::size_t i = 0; i + hop <= pcm.size(); i += hop) {
+    uint64_t t0 = benchNowNs();
+    float hz = det.process(&pcm[i], hop);
+    ns += benchNowNs() - t0;
+    ++hops;
+    if (hz <= 0.f) continue;
+    ++r.pitchedHops;
+    double nowMs = double(i + hop) * 1000.0 / kRate;
+    double m = midiOf(hz);
+    bool matched = false;
+    for (auto& g : groups) {
+      if (nowMs < (double)g.t || nowMs > (double)g.end + 100.0) continue;
+      for (double want : g.midis) {
+        if (std::abs(m - want) <= 0.5) {
+          matched = true;
+          if (!g.found && nowMs <= (double)g.end) {
+            g.found = true;
+            r.latenciesMs.push_back(nowMs - (double)g.t);
+          }
+        }
+      }
+    }
+    if (!matched) ++r.falseHops;
+  }
+  for (auto& g : groups) if (!g.found) ++r.missed;
+  r.nsPerHop = hops ? double(ns) / hops : 0.0;
+  return r;
+}
+
+static double pct(std::vector<double> v, double p) {
+  if (v.empty()) return 0.0;
+  std::sort(v.begin(), v.end());
+  std::size_t idx = std::min(v.size() - 1, (std::size_t)(p / 100.0 * (v.size() - 1) + 0.5));
+  return v[idx];
+}
+
+int main(int argc, char** argv) {
+  bool quick = false;
+  SynthOptions opt;
+  opt.sampleRate = kRate;
+  unsigned hop = 512;
+  for (int i = 1; i < argc; ++i) {
+    std::string_view a = argv[i];
+    if (a == "--quick") quick = true;
+    else if (a == "--noise" && i + 1 < argc) opt.noiseDb = std::atof(argv[++i]);
+    else if (a == "--attack" && i + 1 < argc) opt.pickAttack = std::atof(argv[++i]);
+    else if (a == "--hop" && i + 1 < argc) hop = (unsigned)std::max(64, std::atoi(argv[++i]));
+  }
+
+  int count = quick ? 12 : 100;
+  std::vector<std::pair<std::string, Chart>> scenarios = {
+    {"melody", melodyChart(count, 3)},
+    {"chords", chordChart(count, 5)},
+  };
+
+  for (auto& [scenario, chart] : scenarios) {
+    std::vector<float> pcm = renderChartAudio(chart, opt);
+    std::vector<std::unique_ptr<PitchDetector>> detectors;
+#ifdef RT_ENABLE_AUDIO
+    detectors.push_back(std::make_unique<AubioPitchDetector>(kWin, hop, (unsigned)kRate, -50.f));
+#endif
+    detectors.push_back(std::make_unique<NsdfPitchDetector>(kWin, (float)kRate));
+    for (auto& det : detectors) {
+      DetectResult r = runDetector(*det, chart, pcm, hop);
+      std::string name = std::string(det->name()) + "_" + scenario;
+      emitMetric("detect", name, "latency_mean", r.latenciesMs.empty() ? 0.0 :
+                 std::accumulate(r.latenciesMs.begin(), r.latenciesMs.end(), 0.0) / r.latenciesMs.size(), "ms");
+      emitMetric("detect", name, "latency_p50", pct(r.latenciesMs, 50), "ms");
+      emitMetric("detect", name, "latency_p95", pct(r.latenciesMs, 95), "ms");
+      emitMetric("detect", name, "missed_notes", r.notes ? 100.0 * r.missed / r.notes : 0.0, "%");
+      emitMetric("detect", name, "false_detections", r.pitchedHops ? 100.0 * r.falseHops / r.pitchedHops : 0.0, "%");
+      emitMetric("detect", name, "cpu_per_hop", r.nsPerHop, "ns");
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,177 @@
+#define ROCKTRAINER_NO_MAIN
+#include "../src/main.cpp"
+#include "bench_common.hpp"
+
+// Micro-benchmarks for the hot paths outside rendering: chart loading
+// (JSON and MSS), pitch analysis, MIDI conversions, bitmap text and
+// judgement, each over generated inputs from small to huge. Results are
+// JSON lines (see emitResult) with ns per operation in "ns".
+//
+//   micro_bench [--quick]
+
+static volatile double g_sink = 0.0;
+
+// ns per call of f, after a warm-up pass.
+template <class F>
+static double timeNs(int iters, F&& f) {
+  for (int i = 0; i < std::max(1, iters / 10); ++i) f(i);
+  uint64_t t0 = benchNowNs();
+  for (int i = 0; i < iters; ++i) f(i);
+  return double(benchNowNs() - t0) / iters;
+}
+
+static fs::path writeChartJson(const Chart& c, const fs::path& path) {
+  json j;
+  j["meta"] = {{"bpm", c.bpm}, {"title", c.title}, {"tuning", std::vector<int>(c.tuning.begin(), c.tuning.begin() + c.strings)}};
+  json notes = json::array();
+  for (const auto& n : c.notes) {
+    json jn = {{"t", n.t_ms}, {"str", n.str}, {"fret", n.fret}, {"len", n.len_ms}};
+    if (n.slideTo >= 0) jn["slide"] = n.slideTo;
+    if (!n.techs.empty()) jn["techs"] = n.techs;
+    notes.push_back(jn);
+  }
+  j["notes"] = notes;
+  std::ofstream(path) << j.dump();
+  return path;
+}
+
+static fs::path writeChartMss(const Chart& c, const fs::path& path) {
+  double beatMs = 60000.0 / c.bpm;
+  json j;
+  j["meta"] = {{"bpm", c.bpm}, {"title", c.title}, {"tuning", std::vector<int>(c.tuning.begin(), c.tuning.begin() + c.strings)}};
+  json measures = json::array();
+  for (const auto& n : c.notes) {
+    double beat = n.t_ms / beatMs;
+    std::size_t m = (std::size_t)(beat / 4.0);
+    while (measures.size() <= m) measures.push_back({{"notes", json::array()}});
+    measures[m]["notes"].push_back({{"beat", beat - m * 4.0}, {"string", n.str},
+                                    {"fret", n.fret}, {"sustain", n.len_ms / beatMs}});
+  }
+  j["measures"] = measures;
+  std::ofstream(path) << j.dump();
+  return path;
+}
+
+int main(int argc, char** argv) {
+  bool quick = argc > 1 && std::string_view(argv[1]) == "--quick";
+  std::vector<int> sizes = quick ? std::vector<int>{100, 10000} : std::vector<int>{100, 10000, 100000, 1000000};
+  fs::path tmp = fs::temp_directory_path();
+
+  // Chart loading: ns per note.
+  for (int n : sizes) {
+    Chart c = makeSyntheticChart(n / 60.0, 60, 7);
+    std::string name = std::to_string(c.notes.size()) + "_notes";
+    fs::path pj = writeChartJson(c, tmp / "micro_bench.json");
+    fs::path pm = writeChartMss(c, tmp / "micro_bench.mss");
+    int iters = std::max(1, 200000 / n);
+    double tj = timeNs(iters, [&](int){ g_sink = g_sink + (double)loadChartJson(pj)->notes.size(); });
+    double tm = timeNs(iters, [&](int){ g_sink = g_sink + (double)loadChartMss(pm)->notes.size(); });
+    emitResult("micro", "loadChartJson_" + name, "per_note", tj / c.notes.size());
+    emitResult("micro", "loadChartMss_" + name, "per_note", tm / c.notes.size());
+    fs::remove(pj);
+    fs::remove(pm);
+  }
+
+  // Pitch math over a sweep of guitar frequencies.
+  const int kFreqs = 4096;
+  std::vector<double> freqs(kFreqs);
+  for (int i = 0; i < kFreqs; ++i) freqs[i] = 70.0 * std::pow(2.0, 4.0 * i / kFreqs); // ~E2..E6
+  int pitchIters = quick ? 200000 : 2000000;
+  emitResult("micro", "hzToMidi", "per_call", timeNs(pitchIters, [&](int i){
+    g_sink = g_sink + hzToMidi(freqs[i & (kFreqs - 1)]); }));
+  emitResult("micro", "midiToHz", "per_call", timeNs(pitchIters, [&](int i){
+    g_sink = g_sink + midiToHz(40.0 + (i & 63)); }));
+  emitResult("micro", "fastLog2", "per_call", timeNs(pitchIters, [&](int i){
+    g_sink = g_sink + fastLog2(freqs[i & (kFreqs - 1)]); }));
+  emitResult("micro", "analyzeFrequency", "per_call", timeNs(pitchIters, [&](int i){
+    auto d = analyzeFrequency(freqs[i & (kFreqs - 1)]);
+    g_sink = g_sink + (d ? d->cents : 0.0); }));
+
+  // Judgement: sweep song time across the whole chart at the 1 kHz tick rate.
+  for (int n : sizes) {
+    Chart c = makeSyntheticChart(n / 60.0, 60, 11);
+    float hz = (float)midiToHz(60);
+    CompiledChart cc;
+    double tc = timeNs(20, [&](int){
+      cc.chart = nullptr; // force a recompile
+      cc.sync(c);
+      cc.layout(1152.0 / 4000.0, 90.0 / 24.0);
+      for (std::size_t i = 0; i < c.notes.size(); ++i) g_sink = g_sink + cc.placed(i).lenPx;
+    });
+    emitResult("micro", "compileChart_" + std::to_string(c.notes.size()) + "_notes", "per_note", tc / c.notes.size());
+    // Highway culling: the visible range followed across the song at 60 fps.
+    double tv = timeNs(20, [&](int){
+      VisibleRange vr;
+      for (int64_t ms = 0; ms <= 61000; ms += 16) {
+        vr.update(c.notes, cc.layer(kDifficultyLevels - 1), ms - 2000, ms + 2222);
+        g_sink = g_sink + (double)(vr.last - vr.first);
+      }
+    });
+    emitResult("micro", "visibleRange_" + std::to_string(c.notes.size()) + "_notes", "per_frame", tv / (61000 / 16 + 1));
+    double t = timeNs(3, [&](int){
+      GameplayStats stats;
+      for (int64_t ms = 0; ms <= 61000; ++ms) judgeNotes(stats, cc, ms, hz);
+      g_sink = g_sink + stats.accuracy;
+    });
+    emitResult("micro", "judgeNotes_" + std::to_string(c.notes.size()) + "_notes", "per_tick", t / 61001.0);
+  }
+
+  // WSOLA time-stretch of 10 s of stereo noise-modulated tone: ns per output
+  // frame, and how many times faster than real time at 48 kHz.
+  {
+    const double sr = 48000.0;
+    std::vector<float> in(2 * (std::size_t)(10 * sr));
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> u(-0.05f, 0.05f);
+    for (std::size_t i = 0; i < in.size() / 2; ++i)
+      in[2 * i] = in[2 * i + 1] = 0.4f * (float)std::sin(2.0 * std::numbers::pi * 196.0 * (double)i / sr) + u(rng);
+    for (double rate : {0.5, 0.75}) {
+      TimeStretcher ts;
+      std::vector<float> hop;
+      std::size_t outFrames = 0;
+      double t = timeNs(quick ? 1 : 5, [&](int){
+        ts.reset(sr, 0);
+        hop.resize(2 * (std::size_t)ts.hop);
+        std::size_t fed = 0, total = in.size() / 2;
+        outFrames = 0;
+        for (;;) {
+          while (ts.needed() > 0 && fed < total) {
+            std::size_t n = std::min<std::size_t>(1024, total - fed);
+            ts.push(&in[2 * fed], n);
+            fed += n;
+          }
+          double at;
+          int n = ts.process(hop.data(), rate, at);
+          if (n == 0) break;
+          outFrames += (std::size_t)n;
+          g_sink = g_sink + hop[0];
+        }
+      });
+      std::string name = "timeStretch_x" + std::to_string((int)std::lround(rate * 100));
+      emitResult("micro", name, "per_frame", t / (double)outFrames);
+      emitMetric("micro", name, "realtime_factor", (double)outFrames / sr / (t / 1e9), "x");
+    }
+  }
+
+  // Bitmap text on a software renderer.
+  SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
+  SDL_Init(SDL_INIT_VIDEO);
+  SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, 1280, 720, 32, SDL_PIXELFORMAT_RGBA8888);
+  SDL_Renderer* r = surface ? SDL_CreateSoftwareRenderer(surface) : nullptr;
+  if (!r) {
+    std::fprintf(stderr, "could not create software renderer: %s\n", SDL_GetError());
+    return 1;
+  }
+  for (std::size_t len : {8u, 64u, 512u}) {
+    std::string text(len, 'A');
+    for (std::size_t i = 0; i < len; ++i) text[i] = (char)('A' + i % 26);
+    for (int scale : {1, 4}) {
+      double tt = timeNs(quick ? 50 : 500, [&](int){ drawText(r, text, 0, 100, scale, SDL_Color{255,255,255,255}); });
+      emitResult("micro", "drawText_" + std::to_string(len) + "ch_x" + std::to_string(scale), "per_call", tt);
+    }
+  }
+  SDL_DestroyRenderer(r);
+  SDL_FreeSurface(surface);
+  SDL_Quit();
+  return 0;
+}
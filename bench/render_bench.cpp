@@ -0,0 +1,133 @@
+#define ROCKTRAINER_NO_MAIN
+#include "../src/main.cpp"
+#include "bench_common.hpp"
+
+// Headless rendering benchmark. Renders synthetic charts of increasing note
+// density at several resolutions through drawChart, plus the title and tuner
+// screens, on a software renderer backed by an offscreen surface. Reports
+// ns/frame in total and per profiler phase as JSON lines, and fails if a
+// case's total regresses past --tolerance x the stored baseline.
+//
+//   render_bench [--frames N] [--baseline file] [--update-baseline]
+//                [--tolerance X] [--min-delta-us N]
+//
+// Cases whose slowdown is below --min-delta-us (default 50) are never
+// flagged, so sub-millisecond cases don't fail on scheduler noise.
+
+struct Headless {
+  SDL_Surface* surface = nullptr;
+
+  bool open(App& app, int w, int h) {
+    app.rs.w = w; app.rs.h = h;
+    surface = SDL_CreateRGBSurfaceWithFormat(0, w, h, 32, SDL_PIXELFORMAT_RGBA8888);
+    if (!surface) return false;
+    app.rs.r = SDL_CreateSoftwareRenderer(surface);
+    return app.rs.r && createRenderTargets(app.rs);
+  }
+
+  void close(App& app) {
+    destroyRenderTargets(app.rs);
+    if (app.rs.r) SDL_DestroyRenderer(app.rs.r);
+    if (surface) SDL_FreeSurface(surface);
+    app.rs.r = nullptr;
+    surface = nullptr;
+  }
+};
+
+template <class F>
+static double runCase(const std::string& name, int frames, nlohmann::json& results, F&& frame) {
+  for (int i = 0; i < 3; ++i) frame(i); // warm caches, build static layers
+  Profiler& prof = Profiler::instance();
+  prof.enabled.store(true);
+  uint64_t from = Profiler::nowNs();
+  uint64_t t0 = benchNowNs();
+  for (int i = 0; i < frames; ++i) frame(i);
+  uint64_t t1 = benchNowNs();
+  prof.enabled.store(false);
+  std::vector<PhaseTime> phases;
+  prof.summarize(from, Profiler::nowNs() + 1, phases);
+
+  double total = double(t1 - t0) / frames;
+  emitResult("render", name, "total", total);
+  for (const PhaseTime& p : phases)
+    emitResult("render", name, p.name, p.ms * 1e6 / frames);
+  results[name] = total;
+  return total;
+}
+
+// Exit code when --baseline names a missing or empty file (CTest SKIP_RETURN_CODE).
+constexpr int kNoBaselineExit = 77;
+
+int main(int argc, char** argv) {
+  int frames = 20;
+  std::string baselinePath;
+  bool update = false;
+  double tolerance = 1.5;
+  double minDeltaNs = 50000.0;
+  for (int i = 1; i < argc; ++i) {
+    std::string_view a = argv[i];
+    if (a == "--frames" && i + 1 < argc) frames = std::max(1, std::atoi(argv[++i]));
+    else if (a == "--baseline" && i + 1 < argc) baselinePath = argv[++i];
+    else if (a == "--update-baseline") update = true;
+    else if (a == "--tolerance" && i + 1 < argc) tolerance = std::atof(argv[++i]);
+    else if (a == "--min-delta-us" && i + 1 < argc) minDeltaNs = std::atof(argv[++i]) * 1000.0;
+  }
+
+  SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
+  SDL_Init(SDL_INIT_VIDEO);
+
+  const std::array<std::pair<int,int>,3> resolutions{{{640,360}, {1280,720}, {1920,1080}}};
+  const std::array<double,4> densities{0.0, 4.0, 16.0, 64.0}; // notes per second
+  nlohmann::json results = nlohmann::json::object();
+
+  for (auto [w, h] : resolutions) {
+    App app{};
+    Headless hl;
+    if (!hl.open(app, w, h)) {
+      std::fprintf(stderr, "could not create %dx%d software renderer: %s\n", w, h, SDL_GetError());
+      return 1;
+    }
+    std::string res = std::to_string(w) + "x" + std::to_string(h);
+    for (double d : densities) {
+      app.chart = makeSyntheticChart(d, 60);
+      std::string name = "chart_" + res + "_" + std::to_string((int)d) + "nps";
+      runCase(name, frames, results, [&](int i){
+        drawChart(app, &app.chart, 5000 + i * 16);
+      });
+    }
+    runCase("title_" + res, frames, results, [&](int){ renderTitle(app); });
+    g_detectedHz.store(196.0f, std::memory_order_relaxed);
+    runCase("tuner_" + res, frames, results, [&](int){ renderTuner(app); });
+    g_detectedHz.store(0.0f, std::memory_order_relaxed);
+    hl.close(app);
+  }
+  SDL_Quit();
+
+  int failed = 0;
+  if (!baselinePath.empty()) {
+    if (update) {
+      if (!saveBaseline(baselinePath, results)) {
+        std::fprintf(stderr, "could not write baseline %s\n", baselinePath.c_str());
+        return 1;
+      }
+      std::fprintf(stderr, "baseline written to %s\n", baselinePath.c_str());
+    } else {
+      nlohmann::json base = loadBaseline(baselinePath);
+      if (base.empty()) {
+        // Nothing to compare against: report it to CTest as skipped, not passed.
+        std::fprintf(stderr, "no baseline at %s; run with --update-baseline to record one\n", baselinePath.c_str());
+        return kNoBaselineExit;
+      }
+      for (auto& [name, ns] : results.items()) {
+        if (!base.contains(name) || !base[name].is_number()) continue;
+        double ref = base[name].get<double>();
+        if (ns.get<double>() > ref * tolerance && ns.get<double>() - ref > minDeltaNs) {
+          std::fprintf(stderr, "REGRESSION %s: %.0f ns/frame vs baseline %.0f (x%.2f)\n",
+                       name.c_str(), ns.get<double>(), ref, ns.get<double>() / ref);
+          ++failed;
+        }
+      }
+    }
+  }
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+
+// Lock-free telemetry block written by the audio callback and read by the UI.
+//
+// The callback records its own CPU time and the over/underflow flags the
+// host reports. Durations land in power-of-two microsecond buckets
+// (bucket i holds [2^(i-1), 2^i) us), which is plenty to tell a 50 us
+// callback from a 5 ms one. Everything is relaxed atomics: readers may see
+// a slightly inconsistent mix of counters, never a torn value.
+struct AudioStats {
+  static constexpr int kBuckets = 24;
+
+  // Bits of the callback flags argument; mirror PortAudio's paInput*/paOutput*.
+  static constexpr unsigned long kInputUnderflow  = 0x1;
+  static constexpr unsigned long kInputOverflow   = 0x2;
+  static constexpr unsigned long kOutputUnderflow = 0x4;
+  static constexpr unsigned long kOutputOverflow  = 0x8;
+
+  std::atomic<uint64_t> callbacks{0};
+  std::atomic<uint64_t> inputUnderflows{0};
+  std::atomic<uint64_t> inputOverflows{0};
+  std::atomic<uint64_t> outputUnderflows{0};
+  std::atomic<uint64_t> outputOverflows{0};
+  std::atomic<uint64_t> overBudget{0};   // callbacks that took longer than their buffer
+  std::atomic<uint64_t> totalUs{0};
+  std::atomic<uint32_t> maxUs{0};
+  std::array<std::atomic<uint64_t>, kBuckets> hist{};
+
+  // Set once after the stream opens (main thread, before the overlay reads).
+  double sampleRate = 0.0;
+  double requestedLatencyMs = 0.0;
+  double inputLatencyMs = 0.0;   // as reported by Pa_GetStreamInfo
+  double outputLatencyMs = 0.0;
+
+  static int bucketIndex(uint32_t us) {
+    int i = 0;
+    while (us && i < kBuckets - 1) { us >>= 1; ++i; }
+    return i;
+  }
+
+  // Called from the audio callback.
+  void record(unsigned long flags, uint32_t us, unsigned long frames) {
+    callbacks.fetch_add(1, std::memory_order_relaxed);
+    if (flags & kInputUnderflow)  inputUnderflows.fetch_add(1, std::memory_order_relaxed);
+    if (flags & kInputOverflow)   inputOverflows.fetch_add(1, std::memory_order_relaxed);
+    if (flags & kOutputUnderflow) outputUnderflows.fetch_add(1, std::memory_order_relaxed);
+    if (flags & kOutputOverflow)  outputOverflows.fetch_add(1, std::memory_order_relaxed);
+    totalUs.fetch_add(us, std::memory_order_relaxed);
+    uint32_t prev = maxUs.load(std::memory_order_relaxed);
+    while (us > prev && !maxUs.compare_exchange_weak(prev, us, std::memory_order_relaxed)) {}
+    hist[bucketIndex(us)].fetch_add(1, std::memory_order_relaxed);
+    if (sampleRate > 0.0 && us > (double)frames * 1e6 / sampleRate)
+      overBudget.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  uint64_t xruns() const {
+    return inputUnderflows.load(std::memory_order_relaxed) + inputOverflows.load(std::memory_order_relaxed) +
+           outputUnderflows.load(std::memory_order_relaxed) + outputOverflows.load(std::memory_order_relaxed);
+  }
+
+  double meanUs() const {
+    uint64_t n = callbacks.load(std::memory_order_relaxed);
+    return n ? (double)totalUs.load(std::memory_order_relaxed) / (double)n : 0.0;
+  }
+
+  // Upper bound of the bucket holding percentile p (0..100), in us.
+  uint32_t percentileUs(double p) const {
+    uint64_t n = 0;
+    for (auto& h : hist) n += h.load(std::memory_order_relaxed);
+    if (n == 0) return 0;
+    uint64_t rank = (uint64_t)(p / 100.0 * (double)n);
+    if (rank < 1) rank = 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < kBuckets; ++i) {
+      seen += hist[i].load(std::memory_order_relaxed);
+      if (seen >= rank) return i == 0 ? 0u : (1u << i) - 1u;
+    }
+    return maxUs.load(std::memory_order_relaxed);
+  }
+
+  void printReport(std::FILE* f) const {
+    std::fprintf(f, "audio: %llu callbacks, mean %.0f us, p99 <= %u us, max %u us, %llu over budget\n",
+                 (unsigned long long)callbacks.load(), meanUs(), percentileUs(99), maxUs.load(),
+                 (unsigned long long)overBudget.load());
+    std::fprintf(f, "audio: input underflow %llu, input overflow %llu, output underflow %llu, output overflow %llu\n",
+                 (unsigned long long)inputUnderflows.load(), (unsigned long long)inputOverflows.load(),
+                 (unsigned long long)outputUnderflows.load(), (unsigned long long)outputOverflows.load());
+    std::fprintf(f, "audio: latency requested %.1f ms, achieved input %.1f ms, output %.1f ms @ %.0f Hz\n",
+                 requestedLatencyMs, inputLatencyMs, outputLatencyMs, sampleRate);
+  }
+};
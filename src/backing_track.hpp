@@ -0,0 +1,342 @@
+#pragma once
+#include "clock.hpp"
+#include "time_stretch.hpp"
+#include "wav_reader.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Lock-free single-producer single-consumer ring of interleaved stereo
+// frames. Capacity is fixed at construction (a power of two).
+struct FrameRing {
+  std::vector<float> buf;   // 2 floats per frame
+  std::size_t mask = 0;
+  std::atomic<uint64_t> head{0}; // frames ever written
+  std::atomic<uint64_t> tail{0}; // frames ever read
+
+  explicit FrameRing(std::size_t framesPow2) : buf(framesPow2 * 2), mask(framesPow2 - 1) {}
+
+  std::size_t capacity() const { return mask + 1; }
+  std::size_t readable() const {
+    return (std::size_t)(head.load(std::memory_order_acquire) - tail.load(std::memory_order_relaxed));
+  }
+  std::size_t writable() const {
+    return capacity() - (std::size_t)(head.load(std::memory_order_relaxed) - tail.load(std::memory_order_acquire));
+  }
+
+  // Producer: copy n frames in (n <= writable()).
+  void write(const float* in, std::size_t n) {
+    uint64_t h = head.load(std::memory_order_relaxed);
+    for (std::size_t i = 0; i < n; ++i) {
+      std::size_t j = (std::size_t)((h + i) & mask) * 2;
+      buf[j] = in[2 * i];
+      buf[j + 1] = in[2 * i + 1];
+    }
+    head.store(h + n, std::memory_order_release);
+  }
+
+  // Consumer: copy n frames out (n <= readable()), or drop them if out is null.
+  void read(float* out, std::size_t n) {
+    uint64_t t = tail.load(std::memory_order_relaxed);
+    if (out) {
+      for (std::size_t i = 0; i < n; ++i) {
+        std::size_t j = (std::size_t)((t + i) & mask) * 2;
+        out[2 * i] = buf[j];
+        out[2 * i + 1] = buf[j + 1];
+      }
+    }
+    tail.store(t + n, std::memory_order_release);
+  }
+};
+
+// Song backing audio streamed from a WAV file.
+//
+// A decode thread keeps a fixed-size ring topped up (converting to stereo
+// at the stream's sample rate, and time-stretching when the playback rate
+// isn't 1), so memory is bounded whatever the track length and the audio
+// callback only copies samples. Playback starts once the ring holds
+// kPrimeFrames; the ring is kept small so a rate change is heard within
+// ~0.3 s.
+//
+// Every block the decoder writes carries a marker: the track position of
+// its first frame and the rate it was made at. From these the callback
+// publishes where the output is, and songUsAt() maps a play-clock time to
+// the track position the listener hears then, which is what the song
+// timeline follows while a track plays. restart() rewinds: the decoder
+// seeks, then waits for the callback to discard what was buffered before
+// refilling.
+struct BackingTrack {
+  static constexpr std::size_t kRingFrames = 16384;  // ~340 ms at 48 kHz
+  static constexpr std::size_t kChunkFrames = 1024;  // decoder read size
+  static constexpr std::size_t kPrimeFrames = 8192;
+  static constexpr std::size_t kMarkers = 64;        // > ring frames / smallest block
+  static constexpr double kMinRate = 0.5;
+  static constexpr double kMaxRate = 1.0;
+
+  struct Marker {
+    uint64_t frame;   // ring frame index (FrameRing::head) of the block start
+    double srcFrame;  // track position of that frame, stream-rate frames
+    double rate;      // track frames per output frame within the block
+  };
+
+  WavReader reader;
+  double streamRate = 48000.0;
+  double step = 1.0;                  // file frames per stream frame
+  FrameRing ring{kRingFrames};
+  std::thread thread;
+  std::atomic<bool> running{false};
+  std::atomic<bool> playing{false};   // set by the UI; the callback only plays while true
+  std::atomic<double> rate{1.0};      // playback rate, set by the UI
+  std::atomic<bool> eof{false};
+  std::atomic<uint32_t> flushReq{0};  // decoder -> callback: drop the ring
+  std::atomic<uint32_t> flushAck{0};  // callback -> decoder: dropped
+  std::atomic<bool> rewind{false};    // UI -> decoder
+  std::atomic<bool> stale{false};     // rewind pending: don't publish positions
+  std::atomic<bool> primed{false};
+  std::atomic<uint64_t> underruns{0};
+
+  // Block markers: written by the decoder before the block's frames are
+  // published, read by the callback.
+  std::array<Marker, kMarkers> markers{};
+  std::atomic<uint64_t> markersWritten{0};
+  std::atomic<uint64_t> markersDone{0};   // slots below this may be reused
+
+  // Output side, written by the callback.
+  uint64_t markerCur = 0;
+  uint64_t silentFrames = 0;           // played past the end of the track
+  // Published position: track time at play-clock time, advancing at the
+  // output's rate (0 while paused).
+  TimeAnchor pos;
+  // Decoder state.
+  std::vector<float> src;     // decoded file frames, stereo
+  std::vector<float> scratch; // one read in the file's channel layout
+  double srcPos = 0.0;        // read position within src
+  std::vector<float> outChunk;
+  double made = 0.0;          // stream-rate frames resampled so far (= track position)
+  bool srcEof = false;
+  TimeStretcher stretch;
+  bool stretching = false;
+  std::vector<float> hopBuf;
+
+  BackingTrack() = default;
+  BackingTrack(const BackingTrack&) = delete;
+  BackingTrack& operator=(const BackingTrack&) = delete;
+  ~BackingTrack() { close(); }
+
+  bool isOpen() const { return reader.isOpen(); }
+
+  bool open(const std::string& path, double sampleRate) {
+    close();
+    if (!reader.open(path)) return false;
+    streamRate = sampleRate;
+    step = reader.sampleRate / sampleRate;
+    scratch.resize(kChunkFrames * reader.channels);
+    outChunk.resize(kChunkFrames * 2);
+    resetDecoder();
+    running.store(true);
+    thread = std::thread([this]{ decodeLoop(); });
+    return true;
+  }
+
+  void close() {
+    running.store(false);
+    if (thread.joinable()) thread.join();
+    reader.close();
+  }
+
+  void restart() {
+    stale.store(true, std::memory_order_relaxed);
+    pos.invalidate();
+    rewind.store(true, std::memory_order_release);
+  }
+
+  void setRate(double r) { rate.store(std::clamp(r, kMinRate, kMaxRate), std::memory_order_relaxed); }
+
+  double durationSec() const { return reader.sampleRate > 0 ? (double)reader.totalFrames / reader.sampleRate : 0.0; }
+
+  // Track time (us) heard at play-clock time clockUs, or -1 before playback starts.
+  int64_t songUsAt(int64_t clockUs) const {
+    TimeAnchor::Value v = pos.load();
+    return v.valid ? v.map(clockUs) : -1;
+  }
+
+  // Audio callback: add `frames` frames of track audio to out, whose first
+  // frame reaches the DAC at play-clock time dacUs.
+  void mix(float* out, std::size_t frames, int channels, int64_t dacUs) {
+    uint32_t req = flushReq.load(std::memory_order_acquire);
+    if (req != flushAck.load(std::memory_order_relaxed)) {
+      ring.read(nullptr, ring.readable());
+      markerCur = markersWritten.load(std::memory_order_acquire);
+      markersDone.store(markerCur, std::memory_order_release);
+      silentFrames = 0;
+      primed.store(false, std::memory_order_relaxed);
+      stale.store(false, std::memory_order_relaxed);
+      flushAck.store(req, std::memory_order_release);
+      return;
+    }
+    if (!primed.load(std::memory_order_relaxed)) {
+      if (ring.readable() < kPrimeFrames && !eof.load(std::memory_order_acquire)) return;
+      primed.store(true, std::memory_order_relaxed);
+    }
+    // Where the first frame of this buffer is in the track.
+    uint64_t mw = markersWritten.load(std::memory_order_acquire);
+    uint64_t v = ring.tail.load(std::memory_order_relaxed);
+    while (markerCur + 1 < mw && markers[(markerCur + 1) % kMarkers].frame <= v) ++markerCur;
+    markersDone.store(markerCur, std::memory_order_release);
+    bool play = playing.load(std::memory_order_relaxed);
+    if (markerCur < mw && !stale.load(std::memory_order_relaxed)) {
+      const Marker& m = markers[markerCur % kMarkers];
+      double at = m.srcFrame + (double)(v + silentFrames - m.frame) * m.rate;
+      pos.publish(dacUs, (int64_t)std::llround(at * 1e6 / streamRate), play ? m.rate : 0.0);
+    }
+    if (!play) return;
+    std::size_t done = 0;
+    float tmp[256];
+    while (done < frames) {
+      std::size_t n = std::min<std::size_t>({frames - done, ring.readable(), 128});
+      if (n == 0) break;
+      ring.read(tmp, n);
+      for (std::size_t i = 0; i < n; ++i) {
+        float* o = out + (done + i) * channels;
+        if (channels == 1) o[0] += 0.5f * (tmp[2 * i] + tmp[2 * i + 1]);
+        else { o[0] += tmp[2 * i]; o[1] += tmp[2 * i + 1]; }
+      }
+      done += n;
+    }
+    // Past the end of the file the song goes on in silence; a starved ring
+    // before it is an underrun and holds the song position.
+    if (done < frames) {
+      if (eof.load(std::memory_order_acquire)) silentFrames += frames - done;
+      else underruns.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  void resetDecoder() {
+    reader.seek(0);
+    src.clear();
+    srcPos = 0.0;
+    made = 0.0;
+    srcEof = false;
+    stretching = false;
+    eof.store(false, std::memory_order_release);
+  }
+
+  // Resample up to n stereo stream-rate frames into outChunk; returns frames made.
+  std::size_t decode(std::size_t n) {
+    std::size_t count = 0;
+    while (count < n) {
+      // Need src frames floor(srcPos) and floor(srcPos)+1.
+      std::size_t need = (std::size_t)srcPos + 2;
+      if (src.size() / 2 < need) {
+        std::size_t got = reader.read(scratch.data(), kChunkFrames);
+        if (got == 0) {
+          // End of file: hold the last frame instead of interpolating past it.
+          std::size_t i0 = (std::size_t)srcPos;
+          if (i0 >= src.size() / 2) break;
+          outChunk[2 * count] = src[2 * i0];
+          outChunk[2 * count + 1] = src[2 * i0 + 1];
+          ++count;
+          srcPos += step;
+          continue;
+        }
+        for (std::size_t i = 0; i < got; ++i) {
+          const float* s = &scratch[i * reader.channels];
+          src.push_back(s[0]);
+          src.push_back(reader.channels > 1 ? s[1] : s[0]);
+        }
+        continue;
+      }
+      std::size_t i0 = (std::size_t)srcPos;
+      float fr = (float)(srcPos - (double)i0);
+      outChunk[2 * count] = src[2 * i0] + fr * (src[2 * i0 + 2] - src[2 * i0]);
+      outChunk[2 * count + 1] = src[2 * i0 + 1] + fr * (src[2 * i0 + 3] - src[2 * i0 + 1]);
+      ++count;
+      srcPos += step;
+    }
+    // Drop consumed source frames so src stays about one chunk long.
+    std::size_t used = std::min((std::size_t)srcPos, src.size() / 2);
+    src.erase(src.begin(), src.begin() + used * 2);
+    srcPos -= (double)used;
+    if (count < n) srcEof = true;
+    made += (double)count;
+    return count;
+  }
+
+  // Publish a block of frames with its marker. Waits for a free marker slot.
+  bool writeBlock(const float* frames, std::size_t n, double srcFrame, double r) {
+    uint64_t mw = markersWritten.load(std::memory_order_relaxed);
+    while (mw - markersDone.load(std::memory_order_acquire) >= kMarkers - 1) {
+      if (!running.load(std::memory_order_relaxed)) return false;
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    markers[mw % kMarkers] = Marker{ring.head.load(std::memory_order_relaxed), srcFrame, r};
+    markersWritten.store(mw + 1, std::memory_order_release);
+    ring.write(frames, n);
+    return true;
+  }
+
+  // Top up the ring by about one chunk. Returns false if there was no room
+  // or nothing left to write.
+  bool fill() {
+    if (eof.load(std::memory_order_relaxed) || ring.writable() < kChunkFrames) return false;
+    double r = rate.load(std::memory_order_relaxed);
+    if (!stretching && r == 1.0) {
+      double at = made;
+      std::size_t n = decode(kChunkFrames);
+      if (n) writeBlock(outChunk.data(), n, at, 1.0);
+      if (srcEof) eof.store(true, std::memory_order_release);
+      return n > 0;
+    }
+    if (!stretching) {
+      stretch.reset(streamRate, (int64_t)made);
+      hopBuf.resize(2 * (std::size_t)stretch.hop);
+      stretching = true;
+    }
+    if (r == 1.0) {
+      // Back to plain playback: hand over what the stretcher buffered from
+      // its current position on.
+      int64_t from = std::clamp<int64_t>((int64_t)std::llround(stretch.anaPos), stretch.inBase, stretch.inEnd());
+      std::size_t n = (std::size_t)(stretch.inEnd() - from);
+      stretching = false;
+      if (n > ring.writable()) n = ring.writable();
+      if (n) writeBlock(stretch.at(from), n, (double)from, 1.0);
+      // Frames that didn't fit are dropped (at most a few ms).
+      return true;
+    }
+    while (stretch.needed() > 0) {
+      std::size_t n = decode(kChunkFrames);
+      stretch.push(outChunk.data(), n);
+      if (srcEof && stretch.needed() > 0) {
+        // Pad with silence so the tail still comes out, then stop.
+        if (stretch.anaPos >= made) { eof.store(true, std::memory_order_release); return false; }
+        std::vector<float> zeros(2 * (std::size_t)stretch.needed(), 0.f);
+        stretch.push(zeros.data(), zeros.size() / 2);
+      }
+    }
+    double at = 0.0;
+    int n = stretch.process(hopBuf.data(), r, at);
+    if (n) writeBlock(hopBuf.data(), (std::size_t)n, at, r);
+    return n > 0;
+  }
+
+  void decodeLoop() {
+    while (running.load(std::memory_order_relaxed)) {
+      if (rewind.exchange(false, std::memory_order_acq_rel)) {
+        uint32_t req = flushReq.load(std::memory_order_relaxed) + 1;
+        flushReq.store(req, std::memory_order_release);
+        while (running.load(std::memory_order_relaxed) && flushAck.load(std::memory_order_acquire) != req)
+          std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        resetDecoder();
+      }
+      bool wrote = false;
+      while (running.load(std::memory_order_relaxed) && fill()) wrote = true;
+      if (!wrote) std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+  }
+};
@@ -0,0 +1,238 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <numbers>
+#include <vector>
+
+// Automatic latency calibration.
+//
+// The player (or a loopback cable) answers a train of beats. Beats are
+// scheduled on the play clock; the audio callback renders clicks at their
+// DAC times and timestamps plucks with an onset detector at their ADC
+// times, so each answer's delay is a difference of two play-clock times.
+// The audio pass uses clicks only and measures how late plucks arrive
+// relative to what the player hears: the audio offset that judgement
+// subtracts. The visual pass flashes the screen in silence; how much later
+// those answers come than the audio ones is the display's extra delay,
+// the visual offset the highway is drawn ahead by. Answers are paired with
+// the nearest beat and outliers dropped around the median, so a few
+// missed or doubled plucks don't skew the result.
+
+// Evenly spaced beats on the play clock.
+struct BeatSchedule {
+  int64_t startUs = 0;
+  int64_t periodUs = 600000;
+  int count = 0;
+
+  int64_t timeOf(int k) const { return startUs + (int64_t)k * periodUs; }
+  int64_t endUs() const { return timeOf(count); }
+
+  // Index of the beat nearest to t (may be out of [0, count)).
+  int nearest(int64_t t) const {
+    return (int)std::floor(double(t - startUs) / double(periodUs) + 0.5);
+  }
+};
+
+// Short decaying sine burst, rendered once per sample rate.
+inline std::vector<float> makeClick(double sampleRate, double hz = 1500.0, double ms = 15.0, float gain = 0.6f) {
+  std::size_t n = (std::size_t)(sampleRate * ms / 1000.0);
+  std::vector<float> click(n);
+  double tau = sampleRate * ms / 1000.0 / 5.0;
+  for (std::size_t i = 0; i < n; ++i)
+    click[i] = gain * (float)(std::sin(2.0 * std::numbers::pi * hz * (double)i / sampleRate) * std::exp(-(double)i / tau));
+  return click;
+}
+
+// Mix the clicks of schedule that fall in a buffer into out (interleaved,
+// `channels` wide). The buffer's first frame plays at play-clock time t0Us.
+inline void mixClicks(float* out, std::size_t frames, int channels, int64_t t0Us, double sampleRate,
+                      const BeatSchedule& sched, const std::vector<float>& click) {
+  if (sched.count <= 0 || click.empty()) return;
+  double usPerFrame = 1e6 / sampleRate;
+  int64_t t1Us = t0Us + (int64_t)((double)frames * usPerFrame);
+  int64_t clickUs = (int64_t)((double)click.size() * usPerFrame);
+  int first = std::max(0, sched.nearest(t0Us - clickUs) - 1);
+  for (int k = first; k < sched.count; ++k) {
+    int64_t beat = sched.timeOf(k);
+    if (beat >= t1Us) break;
+    if (beat + clickUs <= t0Us) continue;
+    // Frame offset of the beat relative to the buffer start (may be negative).
+    int64_t off = (int64_t)std::llround(double(beat - t0Us) / usPerFrame);
+    for (std::size_t i = 0; i < frames; ++i) {
+      int64_t j = (int64_t)i - off;
+      if (j < 0) continue;
+      if (j >= (int64_t)click.size()) break;
+      for (int c = 0; c < channels; ++c) out[i * channels + c] += click[(std::size_t)j];
+    }
+  }
+}
+
+// Energy onset detector for plucks and loopback clicks. A peak envelope
+// (30 ms decay, longer than a low E period) is compared with a slowly
+// rising floor; an onset is the first sample where the envelope jumps
+// kRatio above the floor (and above an absolute threshold), at least
+// kRefractoryUs after the previous one.
+struct OnsetDetector {
+  static constexpr float kRatio = 4.0f;            // ~12 dB over the floor
+  static constexpr int64_t kRefractoryUs = 150000;
+  float threshold = 0.01f;                         // -40 dBFS
+  float env = 0.f;
+  float floor = 1e-4f;
+  int64_t lastOnsetUs = INT64_MIN / 2;
+
+  // x[0] was captured at play-clock time t0Us. Calls onOnset(us) per onset.
+  template <class F>
+  void process(const float* x, std::size_t n, int64_t t0Us, double sampleRate, F&& onOnset) {
+    double usPerSample = 1e6 / sampleRate;
+    float decay = (float)std::exp(-1.0 / (0.03 * sampleRate));
+    float rise = (float)(1.0 - std::exp(-1.0 / (0.05 * sampleRate)));
+    for (std::size_t i = 0; i < n; ++i) {
+      env = std::max(std::abs(x[i]), env * decay);
+      if (env > threshold && env > floor * kRatio) {
+        int64_t t = t0Us + (int64_t)((double)i * usPerSample);
+        if (t - lastOnsetUs >= kRefractoryUs) {
+          lastOnsetUs = t;
+          onOnset(t);
+        }
+      }
+      floor = env > floor ? floor + rise * (env - floor) : env;
+      floor = std::max(floor, 1e-5f);
+    }
+  }
+};
+
+// Single-producer single-consumer queue of onset times (audio thread ->
+// UI thread). Full queues drop new onsets.
+struct OnsetQueue {
+  static constexpr uint32_t kSize = 64; // power of two
+  std::array<int64_t, kSize> buf{};
+  std::atomic<uint32_t> head{0}, tail{0};
+
+  bool push(int64_t us) {
+    uint32_t h = head.load(std::memory_order_relaxed);
+    if (h - tail.load(std::memory_order_acquire) == kSize) return false;
+    buf[h & (kSize - 1)] = us;
+    head.store(h + 1, std::memory_order_release);
+    return true;
+  }
+  bool pop(int64_t& us) {
+    uint32_t t = tail.load(std::memory_order_relaxed);
+    if (t == head.load(std::memory_order_acquire)) return false;
+    us = buf[t & (kSize - 1)];
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+  }
+};
+
+struct OffsetEstimate {
+  bool ok = false;
+  double offsetMs = 0.0; // mean delay of the answers kept
+  double jitterMs = 0.0; // their standard deviation
+  int used = 0;
+};
+
+// Pair each onset with the nearest beat from index `skip` on (earlier beats
+// are a count-in) and estimate the typical delay. Answers further than
+// 3 MADs (at least 10 ms) from the median are dropped.
+inline OffsetEstimate estimateOffset(const std::vector<int64_t>& onsetsUs, const BeatSchedule& sched,
+                                     int skip, int minUsed = 6) {
+  std::vector<double> d;
+  std::vector<bool> taken((std::size_t)std::max(sched.count, 0), false);
+  for (int64_t t : onsetsUs) {
+    int k = sched.nearest(t);
+    if (k < skip || k >= sched.count || taken[(std::size_t)k]) continue;
+    taken[(std::size_t)k] = true; // first answer per beat only
+    d.push_back(double(t - sched.timeOf(k)) / 1000.0);
+  }
+  OffsetEstimate r;
+  if (d.empty()) return r;
+  auto median = [](std::vector<double> v) {
+    std::sort(v.begin(), v.end());
+    std::size_t m = v.size() / 2;
+    return v.size() % 2 ? v[m] : 0.5 * (v[m - 1] + v[m]);
+  };
+  double med = median(d);
+  std::vector<double> dev;
+  for (double x : d) dev.push_back(std::abs(x - med));
+  double limit = std::max(3.0 * median(dev), 10.0);
+  double sum = 0.0, sum2 = 0.0;
+  for (double x : d) {
+    if (std::abs(x - med) > limit) continue;
+    sum += x; sum2 += x * x; r.used++;
+  }
+  r.offsetMs = sum / r.used;
+  r.jitterMs = std::sqrt(std::max(0.0, sum2 / r.used - r.offsetMs * r.offsetMs));
+  r.ok = r.used >= minUsed;
+  return r;
+}
+
+// The calibration sequence: an audio pass of clicks, then (unless in
+// loopback mode, where there is nobody to watch) a visual pass of flashes.
+struct Calibrator {
+  enum class Phase { Idle, Audio, Visual, Done };
+  static constexpr int kCountIn = 4;
+  static constexpr int kBeats = 16;              // measured beats per pass
+  static constexpr int64_t kPeriodUs = 600000;   // 100 bpm
+  static constexpr int64_t kLeadUs = 1000000;    // pause before each pass
+  static constexpr int64_t kFlashUs = 80000;
+
+  Phase phase = Phase::Idle;
+  bool loopback = false;
+  BeatSchedule sched;
+  std::vector<int64_t> onsets;
+  OffsetEstimate audio, visual;
+
+  void startPass(Phase p, int64_t nowUs) {
+    phase = p;
+    sched = BeatSchedule{nowUs + kLeadUs, kPeriodUs, kCountIn + kBeats};
+    onsets.clear();
+  }
+
+  void begin(int64_t nowUs, bool loop) {
+    loopback = loop;
+    audio = visual = OffsetEstimate{};
+    startPass(Phase::Audio, nowUs);
+  }
+
+  void addOnset(int64_t us) {
+    if (phase == Phase::Audio || phase == Phase::Visual) onsets.push_back(us);
+  }
+
+  // Finish a pass half a beat after its last beat. Returns true on a phase change.
+  bool update(int64_t nowUs) {
+    if (phase != Phase::Audio && phase != Phase::Visual) return false;
+    if (nowUs < sched.endUs() - kPeriodUs / 2) return false;
+    if (phase == Phase::Audio) {
+      audio = estimateOffset(onsets, sched, kCountIn);
+      if (loopback || !audio.ok) phase = Phase::Done;
+      else startPass(Phase::Visual, nowUs);
+    } else {
+      visual = estimateOffset(onsets, sched, kCountIn);
+      phase = Phase::Done;
+    }
+    return true;
+  }
+
+  bool clicking() const { return phase == Phase::Audio; }
+
+  bool flashing(int64_t nowUs) const {
+    if (phase != Phase::Visual) return false;
+    int k = sched.nearest(nowUs);
+    if (k < 0 || k >= sched.count) return false;
+    int64_t t = nowUs - sched.timeOf(k);
+    return t >= 0 && t < kFlashUs;
+  }
+
+  // Beats left in the current pass, counting the count-in.
+  int beatsLeft(int64_t nowUs) const {
+    if (nowUs < sched.startUs) return sched.count;
+    return std::max(0, sched.count - 1 - (int)((nowUs - sched.startUs) / sched.periodUs));
+  }
+
+  bool ok() const { return audio.ok && (loopback || visual.ok); }
+  int audioOffsetMs() const { return (int)std::lround(audio.offsetMs); }
+  int visualOffsetMs() const { return visual.ok ? (int)std::lround(visual.offsetMs - audio.offsetMs) : 0; }
+};
@@ -5,22 +5,34 @@
 #include <optional>
 #include <filesystem>
 #include <cstdint>
+#include "instrument.hpp"
 
 struct NoteEvent {
   int64_t t_ms;   // start time in ms
-  int      str;   // 1..6 (1 = high E)
+  int      str;   // 1..strings (1 = highest)
   int      fret;  // 0..24
   int64_t len_ms; // duration in ms
   int      slideTo = -1;
   std::vector<std::string> techs;
 };
 
+// Tempo (and time signature) from t_ms on; each change starts a bar.
+struct TempoChange {
+  int64_t t_ms;
+  double bpm;
+  int beatsPerBar = 4;
+};
+
 struct Chart {
   std::vector<NoteEvent> notes;
   double bpm = 120.0;
+  std::vector<TempoChange> tempo; // sorted by t_ms; before the first, bpm in 4/4 from 0
   std::string title = "Example";
-  // MIDI numbers for open strings, low (string 6) to high (string 1)
-  std::array<int,6> tuning{40,45,50,55,59,64};
+  int strings = 6; // 4..kMaxStrings, see instrument.hpp
+  // MIDI numbers for open strings, low (string `strings`) to high (string 1);
+  // entries past `strings` are unused
+  std::array<int,kMaxStrings> tuning{40,45,50,55,59,64};
+  std::string audio; // backing track (WAV) path, empty if none
 };
 
 // Loaders for different chart formats
@@ -14,31 +14,43 @@ std::optional<Chart> loadChartMss(const fs::path& path) {
     auto m = j["meta"];
     if (m.contains("bpm"))   c.bpm = m["bpm"].get<double>();
     if (m.contains("title")) c.title = m["title"].get<std::string>();
-    if (m.contains("tuning") && m["tuning"].is_array() && m["tuning"].size()==6) {
-      for (int i=0;i<6;++i) {
+    if (m.contains("instrument")) instrumentByName(m["instrument"].get<std::string>(), c.strings, c.tuning);
+    if (m.contains("tuning") && m["tuning"].is_array() && m["tuning"].size() >= 4 &&
+        m["tuning"].size() <= (std::size_t)kMaxStrings) {
+      c.strings = (int)m["tuning"].size();
+      for (int i=0;i<c.strings;++i) {
         if (m["tuning"][i].is_number_integer())
           c.tuning[i] = m["tuning"][i].get<int>();
       }
     }
   }
-  double beatMs = 60000.0 / c.bpm;
+  // Measures are 4/4 at the chart bpm unless they say otherwise ("bpm",
+  // "beats"); a change holds until the next one and goes into the tempo map.
+  double bpm = c.bpm;
+  int beats = 4;
+  double measureStartMs = 0.0;
   if (j.contains("measures") && j["measures"].is_array()) {
-    int measureIdx = 0;
     for (auto& mj : j["measures"]) {
-      double measureStartBeats = measureIdx * 4.0; // assume 4/4
+      double newBpm = mj.value("bpm", bpm);
+      int newBeats = mj.value("beats", beats);
+      if (newBpm != bpm || newBeats != beats) {
+        bpm = newBpm;
+        beats = newBeats;
+        c.tempo.push_back(TempoChange{(int64_t)std::llround(measureStartMs), bpm, beats});
+      }
+      double beatMs = 60000.0 / bpm;
       if (mj.contains("notes") && mj["notes"].is_array()) {
         for (auto& n : mj["notes"]) {
           NoteEvent e{};
           e.str  = n.value("string", 1);
           e.fret = n.value("fret", 0);
-          double beat = n.value("beat", 0.0) + measureStartBeats;
-          e.t_ms = static_cast<int64_t>(std::llround(beat * beatMs));
+          e.t_ms = static_cast<int64_t>(std::llround(measureStartMs + n.value("beat", 0.0) * beatMs));
           double sus = n.value("sustain", 0.0);
           e.len_ms = static_cast<int64_t>(std::llround(sus * beatMs));
           c.notes.push_back(e);
         }
       }
-      ++measureIdx;
+      measureStartMs += beats * beatMs;
     }
   }
   std::sort(c.notes.begin(), c.notes.end(),
@@ -0,0 +1,142 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+
+// Time sources for the song timeline, in microseconds from an arbitrary
+// origin. Play state, judgement and rendering read time only through a
+// Clock, so tests and benchmarks can substitute a manual clock and step it
+// exactly, or a scaled one to replay faster than real time.
+struct Clock {
+  virtual ~Clock() = default;
+  virtual int64_t nowUs() const = 0;
+};
+
+// Wall time from std::chrono::steady_clock, zero at construction.
+struct SteadyClock : Clock {
+  std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+  int64_t nowUs() const override {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - origin).count();
+  }
+};
+
+// Advances only when told to. Safe to step from one thread while others read.
+struct ManualClock : Clock {
+  std::atomic<int64_t> us{0};
+  int64_t nowUs() const override { return us.load(std::memory_order_acquire); }
+  void setUs(int64_t t) { us.store(t, std::memory_order_release); }
+  void advanceUs(int64_t dt) { us.fetch_add(dt, std::memory_order_acq_rel); }
+};
+
+// Another clock running `rate` times faster (e.g. 100x replay).
+struct ScaledClock : Clock {
+  const Clock& base;
+  double rate;
+  int64_t start;
+  ScaledClock(const Clock& b, double r) : base(b), rate(r), start(b.nowUs()) {}
+  int64_t nowUs() const override { return (int64_t)((double)(base.nowUs() - start) * rate); }
+};
+
+// A linear mapping between two timelines, published by one thread and read
+// lock-free by others (seqlock): `to` time toUs at `from` time fromUs,
+// advancing rate to-us per from-us. Used for the play clock's mapping onto
+// steady time and for song positions published to the audio callback.
+struct TimeAnchor {
+  struct Value {
+    bool valid = false;
+    int64_t fromUs = 0;
+    int64_t toUs = 0;
+    double rate = 1.0;
+    int64_t map(int64_t t) const { return toUs + (int64_t)std::llround(rate * (double)(t - fromUs)); }
+  };
+
+  std::atomic<uint32_t> seq{0};
+  std::atomic<bool> valid{false};
+  std::atomic<int64_t> fromUs{0};
+  std::atomic<int64_t> toUs{0};
+  std::atomic<double> rate{1.0};
+
+  Value load() const {
+    for (;;) {
+      uint32_t s0 = seq.load(std::memory_order_acquire);
+      Value v{valid.load(std::memory_order_relaxed), fromUs.load(std::memory_order_relaxed),
+              toUs.load(std::memory_order_relaxed), rate.load(std::memory_order_relaxed)};
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (!(s0 & 1) && seq.load(std::memory_order_relaxed) == s0) return v;
+    }
+  }
+
+  void publish(int64_t from, int64_t to, double r) {
+    seq.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    fromUs.store(from, std::memory_order_relaxed);
+    toUs.store(to, std::memory_order_relaxed);
+    rate.store(r, std::memory_order_relaxed);
+    valid.store(true, std::memory_order_relaxed);
+    seq.fetch_add(1, std::memory_order_release);
+  }
+
+  // Readers see !valid until the next publish.
+  void invalidate() { valid.store(false, std::memory_order_release); }
+};
+
+// Runs at the rate of a reference clock that is only observed now and then
+// and with jitter, such as the audio device clock read from its callback.
+//
+// observe(refUs) is called by a single writer with the reference time "now";
+// a second-order loop nudges a linear mapping from the local clock toward
+// it (offset by kOffsetGain of the error, rate by kRateGain), so nowUs()
+// stays smooth and tracks the reference's drift instead of jumping with
+// every callback. The output keeps the local clock's origin: the first
+// observation only fixes `base`, the difference between the two, and
+// fromReferenceUs() converts reference timestamps (e.g. ADC times of
+// detected audio) into this clock's time. A large error (stream restart)
+// re-bases instead of jumping. Until observed it is just the local clock.
+struct SyncedClock : Clock {
+  static constexpr double kOffsetGain = 0.02;
+  static constexpr double kRateGain = 0.0002;
+  static constexpr double kMaxRateError = 0.005;  // +-5000 ppm
+  static constexpr int64_t kResyncUs = 50000;
+
+  const Clock& local;
+
+  // Writer state, touched only by observe().
+  bool synced = false;
+  int64_t lastLocalUs = 0;
+  double rateW = 1.0;
+
+  TimeAnchor anchor;              // now = mapping of the local clock
+  std::atomic<int64_t> base{0};   // reference time minus output time
+
+  explicit SyncedClock(const Clock& l) : local(l) {}
+
+  int64_t map(int64_t localUs) const { return anchor.load().map(localUs); }
+
+  int64_t nowUs() const override { return map(local.nowUs()); }
+
+  int64_t fromReferenceUs(int64_t refUs) const { return refUs - base.load(std::memory_order_acquire); }
+
+  void observe(int64_t refUs) {
+    int64_t l = local.nowUs();
+    int64_t pred = map(l);
+    int64_t out = pred;
+    if (!synced) {
+      synced = true;
+      base.store(refUs - pred, std::memory_order_release);
+    } else {
+      int64_t err = refUs - base.load(std::memory_order_relaxed) - pred;
+      if (err > kResyncUs || err < -kResyncUs) {
+        base.store(refUs - pred, std::memory_order_release);
+      } else if (l > lastLocalUs) {
+        rateW += kRateGain * (double)err / (double)(l - lastLocalUs);
+        rateW = std::clamp(rateW, 1.0 - kMaxRateError, 1.0 + kMaxRateError);
+        out = pred + (int64_t)std::llround(kOffsetGain * (double)err);
+      }
+    }
+    lastLocalUs = l;
+    anchor.publish(l, out, rateW);
+  }
+};
@@ -0,0 +1,187 @@
+#pragma once
+#include "chart.hpp"
+#include "tempo_map.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// Per-note attributes derived from a chart, kept in an array parallel to
+// chart.notes so the render and judgement loops don't re-derive them for
+// every note on every frame or tick.
+//
+// Pitch attributes depend on the chart and its tuning and are rebuilt by
+// sync() when either changes. Pixel attributes depend on the highway zoom
+// and lane size, which can change on any frame; layout() only bumps a
+// generation, and placed() brings a note up to date when it is drawn, so a
+// zoom change costs the notes on screen rather than the whole chart. A
+// sync() that recompiles also invalidates them. Both calls are a few
+// comparisons when nothing changed.
+//
+// Compiling also builds the difficulty layers: for each level, the indices
+// of the notes it keeps, in chart order. Judgement and rendering walk a
+// layer instead of the note array, so every level runs the same code, and
+// changing level is a matter of picking another list (see remap()). Notes
+// are also grouped into phrases, the points where a level may change by
+// itself (see adaptDifficulty in main.cpp): a phrase starts after a rest of
+// at least a beat, or on a downbeat once the current one is four bars long.
+struct CompiledNote {
+  int lane = 0;          // string index (0 = lowest), clamped to the instrument
+  int colorIdx = 0;      // into SettingsState::stringColors
+  int midi = -1;         // expected pitch, -1 if the string doesn't exist
+  float hz = 0.f;
+  float lenPx = 0.f;     // sustain length at the current zoom
+  float slideDy = 0.f;   // slide end relative to its start, px (0 without a slide)
+  uint32_t layoutGen = 0; // CompiledChart::generation the pixel attributes are for
+  int phrase = 0;        // index into CompiledChart::phraseStarts
+};
+
+// Difficulty levels, easiest first; the last is the full chart.
+constexpr int kDifficultyLevels = 4;
+inline constexpr const char* kDifficultyNames[kDifficultyLevels] = {"Easy", "Medium", "Hard", "Full"};
+
+// What a level keeps: notes at least as strong metrically as maxStrength
+// (see TempoMap::strength), at most maxChord notes of a chord (those on the
+// lowest strings, where the root usually is) and nothing above maxFret.
+struct DifficultyRule {
+  int maxStrength;
+  int maxChord;
+  int maxFret;
+};
+
+inline constexpr DifficultyRule kDifficultyRules[kDifficultyLevels] = {
+  {1, 1, 12},                                       // beats, single notes, first 12 frets
+  {2, 1, 17},                                       // eighths
+  {3, 2, 24},                                       // sixteenths, two-note chords
+  {4, kMaxStrings, std::numeric_limits<int>::max()}, // everything
+};
+
+struct CompiledChart {
+  std::vector<CompiledNote> notes;
+  std::array<std::vector<uint32_t>, kDifficultyLevels> layers; // note indices per level
+  std::vector<uint32_t> phraseStarts; // index of each phrase's first note
+
+  // What the attributes were computed from. A chart is recognised by its
+  // address and its note storage, so replacing or growing the notes counts
+  // as a change.
+  const Chart* chart = nullptr;
+  const NoteEvent* noteData = nullptr;
+  std::size_t noteCount = 0;
+  int strings = 0;
+  std::array<int, kMaxStrings> tuning{};
+  double pxPerMs = -1.0;
+  double pxPerFret = -1.0;
+  uint32_t generation = 1;
+
+  // Recompile pitch attributes if c (or its tuning) isn't what they were
+  // built from. Returns true if it recompiled.
+  bool sync(const Chart& c) {
+    if (chart == &c && noteData == c.notes.data() && noteCount == c.notes.size() && strings == c.strings &&
+        tuning == c.tuning)
+      return false;
+    chart = &c;
+    noteData = c.notes.data();
+    noteCount = c.notes.size();
+    strings = c.strings;
+    tuning = c.tuning;
+    notes.resize(noteCount);
+    for (std::size_t i = 0; i < noteCount; ++i) {
+      const NoteEvent& n = c.notes[i];
+      CompiledNote& cn = notes[i];
+      int idx = strings - n.str;
+      cn.lane = std::clamp(idx, 0, strings - 1);
+      cn.colorIdx = stringColorIndex(n.str);
+      cn.midi = idx >= 0 && idx < strings ? tuning[idx] + n.fret : -1;
+      cn.hz = cn.midi >= 0 ? (float)(440.0 * std::pow(2.0, (cn.midi - 69) / 12.0)) : 0.f;
+    }
+    buildLayers(c);
+    pxPerMs = pxPerFret = -1.0;
+    ++generation;
+    return true;
+  }
+
+  // The notes of difficulty `level` (clamped), as indices into chart->notes.
+  const std::vector<uint32_t>& layer(int level) const {
+    return layers[std::clamp(level, 0, kDifficultyLevels - 1)];
+  }
+
+  // Position in layer `to` of the first note at or after position pos of
+  // layer `from`: where a cursor continues after a change of level.
+  std::size_t remap(std::size_t pos, int from, int to) const {
+    const std::vector<uint32_t>& a = layer(from);
+    return position(to, pos < a.size() ? a[pos] : (uint32_t)noteCount);
+  }
+
+  // Position in layer `level` of its first note at or after note index idx.
+  std::size_t position(int level, uint32_t idx) const {
+    const std::vector<uint32_t>& l = layer(level);
+    return (std::size_t)(std::lower_bound(l.begin(), l.end(), idx) - l.begin());
+  }
+
+  // Lay the highway out at pxPerMs with slides moving pxPerFret vertically
+  // per fret. Returns true if that invalidated the pixel attributes.
+  bool layout(double msScale, double fretScale) {
+    if (msScale == pxPerMs && fretScale == pxPerFret) return false;
+    pxPerMs = msScale;
+    pxPerFret = fretScale;
+    ++generation;
+    return true;
+  }
+
+  // Note i with its pixel attributes current.
+  const CompiledNote& placed(std::size_t i) {
+    CompiledNote& cn = notes[i];
+    if (cn.layoutGen != generation) {
+      const NoteEvent& n = chart->notes[i];
+      cn.lenPx = (float)(n.len_ms * pxPerMs);
+      cn.slideDy = n.slideTo >= 0 && n.slideTo != n.fret ? (float)((n.slideTo - n.fret) * pxPerFret) : 0.f;
+      cn.layoutGen = generation;
+    }
+    return cn;
+  }
+
+  // Notes sharing a start time form a chord; its metrical strength and
+  // phrase are worked out once and each level's rule applied to the whole
+  // group.
+  void buildLayers(const Chart& c) {
+    for (auto& l : layers) l.clear();
+    phraseStarts.clear();
+    const TempoMap tempo(c);
+    int64_t lastEnd = 0, phraseMs = 0;
+    for (std::size_t a = 0; a < noteCount;) {
+      const int64_t t = c.notes[a].t_ms;
+      std::size_t b = a + 1;
+      while (b < noteCount && c.notes[b].t_ms == t) ++b;
+      int strength = tempo.strength(t * 1000);
+      TempoMap::Meter m = tempo.meterAt(t * 1000);
+      double beatMs = m.beatUs / 1000.0;
+      if (a == 0 || (double)(t - lastEnd) >= beatMs ||
+          (strength == 0 && (double)(t - phraseMs) >= (4.0 * m.beatsPerBar - 0.5) * beatMs)) {
+        phraseStarts.push_back((uint32_t)a);
+        phraseMs = t;
+      }
+      for (std::size_t i = a; i < b; ++i) {
+        notes[i].phrase = (int)phraseStarts.size() - 1;
+        lastEnd = std::max(lastEnd, t + c.notes[i].len_ms);
+      }
+      for (int level = 0; level < kDifficultyLevels; ++level) {
+        const DifficultyRule& rule = kDifficultyRules[level];
+        if (strength > rule.maxStrength) continue;
+        for (std::size_t i = a; i < b; ++i) {
+          if (c.notes[i].fret > rule.maxFret) continue;
+          // Rank among the chord's notes this level can keep, lowest string first.
+          int lower = 0;
+          for (std::size_t j = a; b - a > (std::size_t)rule.maxChord && j < b; ++j)
+            if (c.notes[j].fret <= rule.maxFret &&
+                (notes[j].lane < notes[i].lane || (notes[j].lane == notes[i].lane && j < i)))
+              ++lower;
+          if (lower < rule.maxChord) layers[level].push_back((uint32_t)i);
+        }
+      }
+      a = b;
+    }
+  }
+};
@@ -0,0 +1,59 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+// Rolling model of how the player is doing, for dynamic difficulty.
+//
+// The last kWindow judged notes are kept in a ring with running sums of
+// hits and of the hits' timing error, so recording a note and reading the
+// hit rate or mean error are O(1) and the model can be fed from the
+// simulation tick. verdict() turns it into a step up or down a level; it
+// waits for kMinNotes notes after every change so one bad phrase doesn't
+// bounce the level back and forth.
+struct DifficultyAdjuster {
+  static constexpr int kWindow = 32;
+  static constexpr int kMinNotes = 16;
+  static constexpr float kRaiseHitRate = 0.9f;  // and error at most kRaiseErrorMs
+  static constexpr float kRaiseErrorMs = 40.f;
+  static constexpr float kLowerHitRate = 0.6f;  // or error above kLowerErrorMs
+  static constexpr float kLowerErrorMs = 75.f;
+
+  std::array<int16_t, kWindow> errorMs{}; // per judged note, -1 for a miss
+  int head = 0;      // next slot to write
+  int count = 0;     // notes in the window
+  int hits = 0;      // hits in the window
+  int errorSum = 0;  // timing error of those hits, ms
+  int sinceChange = 0;
+  int decidedPhrase = -1; // last phrase a verdict was taken for
+
+  // A judged note: a hit off by errMs (real time, either sign) or a miss.
+  void record(bool hit, double errMs) {
+    if (count == kWindow) {
+      int16_t old = errorMs[head];
+      if (old >= 0) { --hits; errorSum -= old; }
+    } else {
+      ++count;
+    }
+    int16_t e = hit ? (int16_t)std::min(std::abs(errMs) + 0.5, 1000.0) : (int16_t)-1;
+    errorMs[head] = e;
+    if (e >= 0) { ++hits; errorSum += e; }
+    head = (head + 1) % kWindow;
+    ++sinceChange;
+  }
+
+  float hitRate() const { return count ? (float)hits / count : 1.f; }
+  float meanErrorMs() const { return hits ? (float)errorSum / hits : 0.f; }
+
+  // +1 to make it harder, -1 to make it easier, 0 to stay.
+  int verdict() const {
+    if (sinceChange < kMinNotes) return 0;
+    if (hitRate() < kLowerHitRate || meanErrorMs() > kLowerErrorMs) return -1;
+    if (hitRate() >= kRaiseHitRate && meanErrorMs() <= kRaiseErrorMs) return 1;
+    return 0;
+  }
+
+  // The level changed: judge the new one on its own notes.
+  void changed() { sinceChange = 0; }
+};
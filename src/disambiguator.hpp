@@ -0,0 +1,103 @@
+#pragma once
+#include "chart.hpp"
+#include "note_table.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numbers>
+
+// Brightness of a block of audio: the frequency of the sine whose mean
+// squared first difference relative to its power matches the block's
+// (a second-moment spectral centroid), computed in one pass without an FFT.
+inline float spectralCentroidHz(const float* x, std::size_t n, double sampleRate) {
+  if (n < 2) return 0.f;
+  double e = 0.0, d = 0.0;
+  for (std::size_t i = 1; i < n; ++i) {
+    e += (double)x[i] * x[i];
+    double v = (double)x[i] - x[i - 1];
+    d += v * v;
+  }
+  if (e <= 0.0) return 0.f;
+  double s = std::min(1.0, std::sqrt(d / e) / 2.0);
+  return (float)(sampleRate / std::numbers::pi * std::asin(s));
+}
+
+// Picks which of a pitch's candidate positions was played.
+//
+// Each candidate is scored on three cues: the chart's expected position for
+// the note being judged (a strong prior), distance from the fretting hand's
+// recent position (open strings are free), and timbre. Fretting higher up a
+// thicker string moves the pluck point toward the middle of what vibrates,
+// so the same pitch sounds darker: log2(centroid / f0) + fret / 12 stays
+// roughly constant for an instrument. That constant is learned from
+// confirmed notes, so timbre only counts once a few have been played.
+//
+// Judgement asks every tick with the same detection, so the last answer is
+// cached on (note, expected position, brightness bucket) and only
+// recomputed when one of those or the learned state changes.
+struct PositionDisambiguator {
+  static constexpr float kExpectedBonus = 1.5f;  // cost units
+  static constexpr float kHandCost = 0.1f;       // per fret from the hand
+  static constexpr float kTimbreCost = 2.0f;     // per octave of brightness mismatch
+  static constexpr float kHandSmoothing = 0.5f;
+  static constexpr float kTimbreSmoothing = 0.2f;
+  static constexpr int kTimbreNotes = 3;         // confirmed notes before timbre counts
+
+  // Learned state.
+  float handFret = -1.f;   // smoothed fret of recent fretted notes, -1 = unknown
+  float openBright = 0.f;  // learned log2(centroid / f0) + fret / 12
+  int timbreNotes = 0;
+  uint32_t version = 0;    // bumped on every confirm()
+
+  // Cache of the last choice.
+  int cMidi = -1, cExpStr = -1, cExpFret = -1, cBright = 0;
+  uint32_t cVersion = ~0u;
+  NotePosition cChoice{-1, -1};
+
+  // log2(centroid / f0), or NaN without a usable centroid.
+  static float brightness(double hz, float centroidHz) {
+    return centroidHz > 0.f && hz > 0.0 ? (float)(fastLog2(centroidHz) - fastLog2(hz)) : NAN;
+  }
+
+  // The position of `midi` most likely played, given the note expected now
+  // (may be null) and the detection's f0 and centroid. {-1, -1} if the
+  // tuning has no position for it.
+  template <class Table>
+  NotePosition choose(const Table& table, int midi, const NoteEvent* expected, double hz, float centroidHz) {
+    int expStr = expected ? Table::Profile::indexOf(expected->str) : -1;
+    int expFret = expected ? expected->fret : -1;
+    float b = brightness(hz, centroidHz);
+    bool useTimbre = timbreNotes >= kTimbreNotes && !std::isnan(b);
+    int bucket = useTimbre ? (int)std::lround(b * 24.f) : INT32_MIN; // quarter-tone steps
+    if (midi == cMidi && expStr == cExpStr && expFret == cExpFret && bucket == cBright && version == cVersion)
+      return cChoice;
+
+    NotePosition best{-1, -1};
+    const auto* e = table.candidates(midi);
+    float bestCost = 1e30f;
+    for (int i = 0; e && i < e->count; ++i) {
+      NotePosition p = e->pos[i];
+      float cost = 0.f;
+      if (p.stringIdx == expStr && p.fret == expFret) cost -= kExpectedBonus;
+      if (handFret >= 0.f && p.fret > 0) cost += kHandCost * std::abs(p.fret - handFret);
+      if (useTimbre) cost += kTimbreCost * std::abs(b + p.fret / 12.f - openBright);
+      if (cost < bestCost) { bestCost = cost; best = p; } // ties keep the lower string
+    }
+    cMidi = midi; cExpStr = expStr; cExpFret = expFret; cBright = bucket; cVersion = version;
+    cChoice = best;
+    return best;
+  }
+
+  // A judged hit at p: move the hand there and learn the timbre.
+  void confirm(NotePosition p, double hz, float centroidHz) {
+    if (p.fret > 0)
+      handFret = handFret < 0.f ? p.fret : handFret + kHandSmoothing * (p.fret - handFret);
+    float b = brightness(hz, centroidHz);
+    if (!std::isnan(b)) {
+      float open = b + p.fret / 12.f;
+      openBright = timbreNotes == 0 ? open : openBright + kTimbreSmoothing * (open - openBright);
+      ++timbreNotes;
+    }
+    ++version;
+  }
+};
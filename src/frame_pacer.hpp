@@ -0,0 +1,56 @@
+#pragma once
+#include <SDL.h>
+#include <algorithm>
+#include <cstdint>
+
+// Deadline-based frame pacing for the main loop.
+//
+// Each frame has an absolute deadline on the SDL performance counter. When
+// the frame's work is done, wait() sleeps with SDL_Delay until shortly before
+// the deadline and spins the rest, so the sleep granularity of the OS doesn't
+// leak into frame times. If the renderer already blocks in present (vsync)
+// and the target is at or above the display rate, pacing turns itself off
+// instead of stacking a sleep on top of the vsync wait.
+struct FramePacer {
+  static constexpr double kSpinMs = 1.5; // final stretch handled by busy-wait
+
+  Uint64 freq = 1;
+  Uint64 period = 0;     // counter ticks per frame; 0 = don't pace
+  Uint64 deadline = 0;   // counter value the current frame should end at
+  Uint64 frameStart = 0;
+  double workMs = 0.0;   // time between beginFrame() and wait() last frame
+
+  // targetFps <= 0 means unlimited. displayHz <= 0 if unknown.
+  void configure(int targetFps, bool vsync, int displayHz) {
+    freq = SDL_GetPerformanceFrequency();
+    period = 0;
+    if (targetFps <= 0) return;
+    if (vsync && (displayHz <= 0 || targetFps >= displayHz)) return;
+    period = freq / (Uint64)targetFps;
+    deadline = 0;
+  }
+
+  bool active() const { return period != 0; }
+
+  void beginFrame() {
+    frameStart = SDL_GetPerformanceCounter();
+    if (!active()) return;
+    if (deadline == 0) deadline = frameStart + period;
+  }
+
+  void wait() {
+    Uint64 now = SDL_GetPerformanceCounter();
+    workMs = double(now - frameStart) * 1000.0 / double(freq);
+    if (!active()) return;
+    if (now < deadline) {
+      double remainMs = double(deadline - now) * 1000.0 / double(freq);
+      if (remainMs > kSpinMs) SDL_Delay((Uint32)(remainMs - kSpinMs));
+      while (SDL_GetPerformanceCounter() < deadline) {}
+      deadline += period;
+    } else {
+      // Missed the deadline: start a fresh schedule instead of bursting
+      // several short frames to catch up.
+      deadline = now + period;
+    }
+  }
+};
@@ -0,0 +1,85 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Session-long frame time statistics.
+//
+// Frame times go into a log-linear histogram in the style of HdrHistogram:
+// each power-of-two range of microseconds is split into kSubBuckets linear
+// buckets, so percentiles keep ~1.5% relative precision from 1 us up to
+// ~67 s without storing every sample. A frame counts as dropped when it
+// took longer than 1.5x the target frame period. Raw per-frame times can
+// optionally be kept for a CSV export at exit.
+struct FrameStats {
+  static constexpr int kSubBucketBits = 6;               // 64 sub-buckets
+  static constexpr int kSubBuckets = 1 << kSubBucketBits;
+  static constexpr int kMagnitudes = 26;                 // up to 2^(26+6) us
+  static constexpr int kBuckets = kMagnitudes * kSubBuckets;
+
+  std::array<uint64_t, kBuckets> counts{};
+  uint64_t total = 0;
+  uint64_t dropped = 0;
+  uint64_t maxUs = 0;
+  double sumMs = 0.0;
+  double targetMs = 1000.0 / 60.0;
+  bool keepSamples = false;
+  std::vector<float> samples; // per-frame ms, only when keepSamples
+
+  static int bucketIndex(uint64_t us) {
+    if (us < (uint64_t)kSubBuckets) return (int)us;
+    int msb = (int)std::bit_width(us) - 1;             // us >= 64, so msb >= 6
+    int mag = msb - kSubBucketBits + 1;                // 1..
+    int sub = (int)(us >> (mag - 1)) - kSubBuckets;    // 0..kSubBuckets-1
+    int idx = mag * kSubBuckets + sub;
+    return std::min(idx, kBuckets - 1);
+  }
+
+  // Upper bound (in us) of the values that land in bucket idx.
+  static uint64_t bucketValue(int idx) {
+    int mag = idx / kSubBuckets;
+    int sub = idx % kSubBuckets;
+    if (mag == 0) return (uint64_t)sub;
+    return ((uint64_t)(sub + kSubBuckets + 1) << (mag - 1)) - 1;
+  }
+
+  void record(double ms) {
+    uint64_t us = ms <= 0.0 ? 0 : (uint64_t)std::llround(ms * 1000.0);
+    counts[bucketIndex(us)]++;
+    total++;
+    sumMs += ms;
+    maxUs = std::max(maxUs, us);
+    if (ms > targetMs * 1.5) dropped++;
+    if (keepSamples) samples.push_back((float)ms);
+  }
+
+  // Value at percentile p (0..100) in milliseconds.
+  double percentile(double p) const {
+    if (total == 0) return 0.0;
+    uint64_t rank = (uint64_t)std::ceil(p / 100.0 * (double)total);
+    rank = std::clamp<uint64_t>(rank, 1, total);
+    uint64_t seen = 0;
+    for (int i = 0; i < kBuckets; ++i) {
+      seen += counts[i];
+      if (seen >= rank) return std::min(bucketValue(i), maxUs) / 1000.0;
+    }
+    return maxUs / 1000.0;
+  }
+
+  double maxMs() const { return maxUs / 1000.0; }
+  double meanMs() const { return total ? sumMs / (double)total : 0.0; }
+
+  bool writeCsv(const std::string& path) const {
+    std::FILE* f = std::fopen(path.c_str(), "w");
+    if (!f) return false;
+    std::fputs("frame,ms\n", f);
+    for (std::size_t i = 0; i < samples.size(); ++i)
+      std::fprintf(f, "%zu,%.3f\n", i, samples[i]);
+    return std::fclose(f) == 0;
+  }
+};
@@ -0,0 +1,73 @@
+#pragma once
+#include "chart.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Note highway geometry. Time runs right to left through the hit line: a
+// note dt ms ahead of now is drawn at x(dt) = hitX + dt * pxPerMs.
+//
+// Scroll speed scales pxPerMs (1.0 moves 0.9 screen widths per 4 s). The
+// look-ahead is how far ahead the highway must reach; the hit line moves
+// left to fit it, from the centre down to 10% of the width, and the rest of
+// the screen right of the line is always used. Both are user settings that
+// may change on any frame: the view is rebuilt per frame in O(1), and the
+// per-note pixel attributes that depend on it are recomputed lazily by
+// CompiledChart::placed().
+struct HighwayView {
+  static constexpr double kBaseScale = 0.9 / 4000.0; // screen widths per ms at speed 1
+  static constexpr double kMinSpeed = 0.25, kMaxSpeed = 4.0;
+  static constexpr int kMinLookAheadMs = 500, kMaxLookAheadMs = 10000;
+  static constexpr double kBehindMs = 2000.0; // notes stay drawn this long past the line
+
+  double pxPerMs = 0.0;
+  double hitX = 0.0;
+  double aheadMs = 0.0;  // time shown right of the line, at least the look-ahead if it fits
+  double behindMs = 0.0; // time shown left of the line
+
+  HighwayView(int width, double speed, int lookAheadMs) {
+    pxPerMs = std::max(width, 1) * kBaseScale * std::clamp(speed, kMinSpeed, kMaxSpeed);
+    double ahead = std::clamp(lookAheadMs, kMinLookAheadMs, kMaxLookAheadMs);
+    hitX = std::clamp(width - ahead * pxPerMs, width * 0.1, width * 0.5);
+    aheadMs = (width - hitX) / pxPerMs;
+    behindMs = std::min(kBehindMs, hitX / pxPerMs);
+  }
+
+  double x(double dtMs) const { return hitX + dtMs * pxPerMs; }
+  // Notes fade from full at the line to 0.44 at the right edge.
+  double depth(double dtMs) const { return std::clamp(1.0 - std::abs(dtMs) / (1.8 * aheadMs), 0.0, 1.0); }
+};
+
+// Positions [first, last) in a difficulty layer (note indices in chart
+// order, see CompiledChart::layer) of the notes starting within
+// [fromMs, toMs], kept across frames. Notes are sorted by start time, so
+// each update walks both edges from where they were: a frame costs the
+// notes that entered or left the window, whichever way time or the window
+// bounds moved. An edge that has to move further than kMaxWalk (a seek, a
+// restart, another chart or layer) falls back to a binary search.
+struct VisibleRange {
+  static constexpr std::size_t kMaxWalk = 64;
+
+  std::size_t first = 0, last = 0;
+
+  void update(const std::vector<NoteEvent>& notes, const std::vector<uint32_t>& layer, int64_t fromMs,
+              int64_t toMs) {
+    first = seek(layer, first, [&](uint32_t i) { return notes[i].t_ms < fromMs; });
+    last = seek(layer, std::max(last, first), [&](uint32_t i) { return notes[i].t_ms <= toMs; });
+  }
+
+  // First position at or after which before() is false, starting from i.
+  template <class Before>
+  static std::size_t seek(const std::vector<uint32_t>& layer, std::size_t i, Before before) {
+    const std::size_t n = layer.size();
+    i = std::min(i, n);
+    for (std::size_t steps = 0; steps < kMaxWalk; ++steps) {
+      if (i < n && before(layer[i])) ++i;
+      else if (i > 0 && !before(layer[i - 1])) --i;
+      else return i;
+    }
+    return (std::size_t)(std::partition_point(layer.begin(), layer.end(), before) - layer.begin());
+  }
+};
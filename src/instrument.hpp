@@ -0,0 +1,86 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <string_view>
+
+// Fretted instruments by string count. Charts number strings from 1 (the
+// highest) to kStrings (the lowest); string indices into tunings, lanes and
+// note tables run the other way, 0 being the lowest string.
+//
+// Code that loops over strings or frets is written against a profile, so
+// each instantiation gets constant trip counts and fixed-size arrays; the
+// runtime string count is turned into a profile once per call with
+// withInstrument().
+constexpr int kMaxStrings = 8;
+
+template <int Strings, int Frets = 24>
+struct InstrumentProfile {
+  static_assert(Strings >= 4 && Strings <= kMaxStrings, "4 to 8 strings");
+  static constexpr int kStrings = Strings;
+  static constexpr int kFrets = Frets;
+
+  static constexpr int indexOf(int str) { return Strings - str; }
+  static constexpr int stringOf(int idx) { return Strings - idx; }
+
+  // Standard tuning, lowest string first: E standard for six strings, with
+  // a low B (and F#) below it for seven (eight); E1 A1 D2 G2 for basses,
+  // with a low B0 for five.
+  static constexpr std::array<int, Strings> standardTuning() {
+    constexpr int guitar[kMaxStrings] = {30, 35, 40, 45, 50, 55, 59, 64};
+    constexpr int bass[5] = {23, 28, 33, 38, 43};
+    std::array<int, Strings> t{};
+    for (int i = 0; i < Strings; ++i)
+      t[i] = Strings <= 5 ? bass[5 - Strings + i] : guitar[kMaxStrings - Strings + i];
+    return t;
+  }
+};
+
+using Bass4 = InstrumentProfile<4>;
+using Bass5 = InstrumentProfile<5>;
+using Guitar6 = InstrumentProfile<6>;
+using Guitar7 = InstrumentProfile<7>;
+using Guitar8 = InstrumentProfile<8>;
+
+// Colour slot for string number str (1 = highest): the six-string slots low
+// E..high E, then the 7th and 8th strings, so a string keeps its colour
+// whatever the instrument.
+constexpr int stringColorIndex(int str) {
+  return str <= 6 ? std::min(6 - str, 5) : std::min(str - 1, kMaxStrings - 1);
+}
+
+// Call f(Profile{}) for an instrument with `strings` strings (six if the
+// count isn't supported).
+template <class F>
+decltype(auto) withInstrument(int strings, F&& f) {
+  switch (strings) {
+    case 4: return f(Bass4{});
+    case 5: return f(Bass5{});
+    case 7: return f(Guitar7{});
+    case 8: return f(Guitar8{});
+    default: return f(Guitar6{});
+  }
+}
+
+// String count and tuning (lowest first) of a named instrument: "bass",
+// "bass5", "guitar", "guitar7", "guitar8" or "baritone" (six strings, B
+// standard). Returns false for unknown names.
+inline bool instrumentByName(std::string_view name, int& strings, std::array<int, kMaxStrings>& tuning) {
+  auto set = [&](auto p) {
+    strings = p.kStrings;
+    tuning = {};
+    auto t = p.standardTuning();
+    for (int i = 0; i < p.kStrings; ++i) tuning[i] = t[i];
+    return true;
+  };
+  if (name == "bass") return set(Bass4{});
+  if (name == "bass5") return set(Bass5{});
+  if (name == "guitar") return set(Guitar6{});
+  if (name == "guitar7") return set(Guitar7{});
+  if (name == "guitar8") return set(Guitar8{});
+  if (name == "baritone") {
+    set(Guitar6{});
+    for (int i = 0; i < 6; ++i) tuning[i] -= 5;
+    return true;
+  }
+  return false;
+}
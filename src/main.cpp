@@ -2,6 +2,7 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <ctime>
 #include <string>
 #include <vector>
 #include <array>
@@ -24,6 +25,21 @@
 #endif
 #include <SDL.h>
 #include "font8x8_basic.h"
+#include "frame_pacer.hpp"
+#include "profiler.hpp"
+#include "frame_stats.hpp"
+#include "audio_stats.hpp"
+#include "clock.hpp"
+#include "calibration.hpp"
+#include "backing_track.hpp"
+#include "metronome.hpp"
+#include "tempo_map.hpp"
+#include "note_table.hpp"
+#include "disambiguator.hpp"
+#include "compiled_chart.hpp"
+#include "highway.hpp"
+#include "dda.hpp"
+#include "session_log.hpp"
 
 // nlohmann json (header-only). Install via package manager.
 // If CMake can't find it automatically, ensure its include dir is visible.
@@ -36,16 +52,24 @@ static constexpr double kSampleRate = 48000.0;
 static constexpr unsigned kHopSize = 512;   // buffer size per callback
 static constexpr unsigned kWinSize = 2048;  // analysis window
 static constexpr float  kSilenceDb = -50.0f;
-static constexpr int    kMaxFrets = 24;
+static constexpr int    kMaxFrets = 24;        // fret hints; every instrument profile has 24
 static constexpr int    kFrameHistory = 120;
 
 // --------- Globals (simple starter) ---------
 static std::atomic<float> g_detectedHz{0.0f};
+static std::atomic<float> g_detectedCentroidHz{0.0f}; // brightness of the hop g_detectedHz came from
+static std::atomic<int64_t> g_detectedAtUs{0};   // play Clock time the detected audio was captured, 0 = unknown
 static std::atomic<int>   g_latencyOffsetMs{0};  // visual offset
+static std::atomic<int>   g_audioOffsetMs{0};    // calibrated: detections arrive this late
+static std::atomic<int>   g_visualOffsetMs{0};   // calibrated: the highway is drawn this far ahead
+static AudioStats         g_audioStats;          // written by audioCb
 
 // Standard tuning MIDI numbers for open strings (low→high): E2 A2 D3 G3 B3 E4
-static std::array<int,6> g_stringOpenMidi{40,45,50,55,59,64};
-static std::array<std::string,6> g_stringNames{"E2","A2","D3","G3","B3","E4"};
+static constexpr std::array<int,6> kStringOpenMidi = Guitar6::standardTuning();
+static std::atomic<int> g_strings{6}; // string count of the loaded chart's instrument
+// Note tables per instrument profile; the loaded chart's is rebuilt for its tuning.
+template <class Profile> static BasicNoteTable<Profile> g_noteTable;
+static std::array<std::string,kMaxStrings> g_stringNames{"E2","A2","D3","G3","B3","E4"};
 
 struct AudioDevice {
   int index = -1;
@@ -57,12 +81,23 @@ struct SettingsState {
   int audioDeviceIndex = -1;
   int bufferSize = kHopSize;
   int latencyOffset = 0;
+  int audioOffsetMs = 0;  // from latency calibration
+  int visualOffsetMs = 0;
+  bool metronome = false; // click track in Play
+  int difficulty = kDifficultyLevels - 1; // 0 = easiest layer, see compiled_chart.hpp
+  bool adaptiveDifficulty = false;        // adjust it between phrases during Play
+  bool recordSessions = false; // log each Play session to sessions/ for --replay
+  double scrollSpeed = 1.0; // highway speed, 1.0 = 0.9 screen widths per 4 s
+  int lookAheadMs = 2000;   // how far ahead the highway must reach
   bool vsync = true;
+  int targetFps = 60; // 60/120/144, 0 = unlimited
   int width = 1280;
   int height = 720;
-  std::array<SDL_Color,6> stringColors{
+  // Six-string order (low E..high E), then the 7th and 8th strings.
+  std::array<SDL_Color,kMaxStrings> stringColors{
     SDL_Color{128,0,255,255}, {0,0,255,255}, {0,255,0,255},
-    {255,255,0,255}, {255,128,0,255}, {255,0,0,255}
+    {255,255,0,255}, {255,128,0,255}, {255,0,0,255},
+    {255,0,160,255}, {120,120,140,255}
   };
 };
 
@@ -92,7 +127,16 @@ static bool loadConfig(const std::string& path, SettingsState& st) {
   st.audioDeviceIndex = j.value("audio_device", st.audioDeviceIndex);
   st.bufferSize = j.value("buffer_size", st.bufferSize);
   st.latencyOffset = j.value("latency_offset", st.latencyOffset);
+  st.audioOffsetMs = j.value("audio_offset_ms", st.audioOffsetMs);
+  st.visualOffsetMs = j.value("visual_offset_ms", st.visualOffsetMs);
+  st.metronome = j.value("metronome", st.metronome);
+  st.difficulty = std::clamp(j.value("difficulty", st.difficulty), 0, kDifficultyLevels - 1);
+  st.adaptiveDifficulty = j.value("adaptive_difficulty", st.adaptiveDifficulty);
+  st.recordSessions = j.value("record_sessions", st.recordSessions);
+  st.scrollSpeed = j.value("scroll_speed", st.scrollSpeed);
+  st.lookAheadMs = j.value("look_ahead_ms", st.lookAheadMs);
   st.vsync = j.value("vsync", st.vsync);
+  st.targetFps = j.value("target_fps", st.targetFps);
   st.width = j.value("width", st.width);
   st.height = j.value("height", st.height);
   if (j.contains("string_colors") && j["string_colors"].is_array()) {
@@ -109,7 +153,16 @@ static bool saveConfig(const std::string& path, const SettingsState& st) {
   j["audio_device"] = st.audioDeviceIndex;
   j["buffer_size"] = st.bufferSize;
   j["latency_offset"] = st.latencyOffset;
+  j["audio_offset_ms"] = st.audioOffsetMs;
+  j["visual_offset_ms"] = st.visualOffsetMs;
+  j["metronome"] = st.metronome;
+  j["difficulty"] = st.difficulty;
+  j["adaptive_difficulty"] = st.adaptiveDifficulty;
+  j["record_sessions"] = st.recordSessions;
+  j["scroll_speed"] = st.scrollSpeed;
+  j["look_ahead_ms"] = st.lookAheadMs;
   j["vsync"] = st.vsync;
+  j["target_fps"] = st.targetFps;
   j["width"] = st.width;
   j["height"] = st.height;
   std::vector<std::string> cols;
@@ -136,33 +189,20 @@ inline std::pair<std::string,int> midiToName(int midi) {
   int octave = (midi/12) - 1;
   return {names[n], octave};
 }
-struct DetectedNote {
-  int midi;          // nearest midi
-  double cents;      // deviation from nearest
-  int stringIdx;     // 0..5 (low E..high E) best match
-  int fret;          // 0..24 if in range, else -1
-};
+// Nearest note and default string/fret for the current tuning.
 inline std::optional<DetectedNote> analyzeFrequency(double hz) {
-  if (hz <= 0.0) return std::nullopt;
-  double midiF = hzToMidi(hz);
-  int midi = (int)std::round(midiF);
-  double refHz = midiToHz(midi);
-  double cents = 1200.0 * std::log2(hz / refHz);
+  return withInstrument(g_strings.load(std::memory_order_relaxed),
+                        [&](auto p) { return g_noteTable<decltype(p)>.classify(hz); });
+}
 
-  // pick string/fret by proximity
-  int bestStr = -1, bestFret = -1;
-  double bestDiff = 1e9;
-  for (int s = 0; s < 6; ++s) {
-    int fret = midi - g_stringOpenMidi[s];
-    if (fret < 0 || fret > kMaxFrets) continue;
-    double diff = std::abs((double)fret - (midi - g_stringOpenMidi[s]));
-    if (diff < bestDiff) {
-      bestDiff = diff;
-      bestStr = s;
-      bestFret = fret;
-    }
+// Make the chart's instrument and tuning the current one.
+inline void setInstrument(const Chart& c) {
+  withInstrument(c.strings, [&](auto p) { g_noteTable<decltype(p)>.build(c.tuning.data()); });
+  g_strings.store(c.strings);
+  for (int i = 0; i < kMaxStrings; ++i) {
+    auto [n, oct] = midiToName(c.tuning[i]);
+    g_stringNames[i] = i < c.strings ? n + std::to_string(oct) : "";
   }
-  return DetectedNote{midi, cents, bestStr, bestFret};
 }
 
 inline void drawChar(SDL_Renderer* r, char c, int x, int y, int scale, SDL_Color col) {
@@ -199,8 +239,18 @@ std::optional<Chart> loadChartJson(const fs::path& path) {
     auto m = j["meta"];
     if (m.contains("bpm"))   c.bpm = m["bpm"].get<double>();
     if (m.contains("title")) c.title = m["title"].get<std::string>();
-    if (m.contains("tuning") && m["tuning"].is_array() && m["tuning"].size()==6) {
-      for (int i=0;i<6;++i) {
+    if (m.contains("audio")) c.audio = (path.parent_path() / m["audio"].get<std::string>()).string();
+    if (m.contains("tempo") && m["tempo"].is_array()) {
+      for (auto& tj : m["tempo"])
+        c.tempo.push_back(TempoChange{tj.value("t", (int64_t)0), tj.value("bpm", c.bpm), tj.value("beats", 4)});
+      std::sort(c.tempo.begin(), c.tempo.end(),
+        [](const TempoChange& a, const TempoChange& b){return a.t_ms < b.t_ms;});
+    }
+    if (m.contains("instrument")) instrumentByName(m["instrument"].get<std::string>(), c.strings, c.tuning);
+    if (m.contains("tuning") && m["tuning"].is_array() && m["tuning"].size() >= 4 &&
+        m["tuning"].size() <= (std::size_t)kMaxStrings) {
+      c.strings = (int)m["tuning"].size();
+      for (int i=0;i<c.strings;++i) {
         if (m["tuning"][i].is_number_integer())
           c.tuning[i] = m["tuning"][i].get<int>();
       }
@@ -232,19 +282,92 @@ std::optional<Chart> loadChart(const fs::path& path) {
   return std::nullopt;
 }
 
+// --------- Calibration link ---------
+// What the calibration screen asks of the audio callback: clicks to play and
+// whether to report onsets. The schedule is written before `clicking` is
+// raised and only while it is down.
+struct CalibrationLink {
+  std::atomic<bool> clicking{false};
+  std::atomic<bool> listening{false};
+  std::atomic<int64_t> startUs{0};
+  std::atomic<int64_t> periodUs{1};
+  std::atomic<int> count{0};
+  OnsetQueue onsets;               // play-clock times, audio -> UI thread
+
+  BeatSchedule schedule() const {
+    return BeatSchedule{startUs.load(std::memory_order_relaxed), periodUs.load(std::memory_order_relaxed),
+                        count.load(std::memory_order_relaxed)};
+  }
+};
+static CalibrationLink g_calibration;
+
 #ifdef RT_ENABLE_AUDIO
 // --------- PortAudio + aubio ---------
 struct AudioState {
   fvec_t* inputFrame = nullptr;
+  fvec_t* pitchOut = nullptr; // 1-sample aubio output, allocated up front
   aubio_pitch_t* pitch = nullptr;
   unsigned hop = kHopSize;
+  SyncedClock* clock = nullptr; // play clock, slaved to this stream's time
+  int outChannels = 0;          // 0 = input-only stream
+  OnsetDetector onset;
+  std::vector<float> click;     // pre-rendered calibration click
+  BackingTrack* track = nullptr; // mixed into the output when open
+  Metronome* metronome = nullptr;
+  const TimeAnchor* song = nullptr; // song time at play-clock time, for the metronome
+  ProfileRing* profileRing = nullptr; // registered before the stream starts
 };
 
-static int audioCb(const void* input, void*, unsigned long frameCount,
-                   const PaStreamCallbackTimeInfo*, PaStreamCallbackFlags, void* userData) {
+static_assert(AudioStats::kInputUnderflow == paInputUnderflow && AudioStats::kInputOverflow == paInputOverflow &&
+              AudioStats::kOutputUnderflow == paOutputUnderflow && AudioStats::kOutputOverflow == paOutputOverflow,
+              "AudioStats flag bits must match PortAudio");
+
+// Records callback CPU time and xrun flags into g_audioStats on scope exit.
+struct AudioCallbackTimer {
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  PaStreamCallbackFlags flags;
+  unsigned long frames;
+  ~AudioCallbackTimer() {
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start).count();
+    g_audioStats.record(flags, (uint32_t)us, frames);
+  }
+};
+
+static int audioCb(const void* input, void* output, unsigned long frameCount,
+                   const PaStreamCallbackTimeInfo* timeInfo, PaStreamCallbackFlags statusFlags, void* userData) {
   auto* st = reinterpret_cast<AudioState*>(userData);
+  // The host may call from any thread; never let the profiler allocate here.
+  if (st->profileRing) Profiler::useRing(st->profileRing);
+  RT_PROFILE_SCOPE("audioCb");
+  AudioCallbackTimer timer{std::chrono::steady_clock::now(), statusFlags, frameCount};
+  // Some host APIs leave the stream times at 0; then the play clock stays on
+  // steady_clock and detections go unstamped.
+  bool timed = st->clock && timeInfo && timeInfo->currentTime > 0.0;
+  if (timed) st->clock->observe((int64_t)(timeInfo->currentTime * 1e6));
+  double sr = g_audioStats.sampleRate;
+  if (output) {
+    float* out = static_cast<float*>(output);
+    std::fill(out, out + frameCount * st->outChannels, 0.f);
+    int64_t dacUs = !st->clock ? 0
+                  : timed ? st->clock->fromReferenceUs((int64_t)(timeInfo->outputBufferDacTime * 1e6))
+                          : st->clock->nowUs() + (int64_t)(g_audioStats.outputLatencyMs * 1000.0);
+    if (st->track && st->track->isOpen()) st->track->mix(out, frameCount, st->outChannels, dacUs);
+    if (const Chart* c = st->metronome ? st->metronome->chart.load(std::memory_order_acquire) : nullptr) {
+      TimeAnchor::Value song = st->song->load();
+      if (song.valid)
+        st->metronome->mix(out, frameCount, st->outChannels, sr, TempoMap(*c), song.map(dacUs), song.rate);
+    }
+    if (g_calibration.clicking.load(std::memory_order_acquire) && st->clock)
+      mixClicks(out, frameCount, st->outChannels, dacUs, sr, g_calibration.schedule(), st->click);
+  }
   if (!input) return paContinue;
   const float* in = static_cast<const float*>(input);
+  if (g_calibration.listening.load(std::memory_order_relaxed) && st->clock) {
+    int64_t adcUs = timed ? st->clock->fromReferenceUs((int64_t)(timeInfo->inputBufferAdcTime * 1e6))
+                          : st->clock->nowUs() - (int64_t)(g_audioStats.inputLatencyMs * 1000.0);
+    st->onset.process(in, frameCount, adcUs, sr, [](int64_t us){ g_calibration.onsets.push(us); });
+  }
   // Feed aubio in hop-sized chunks
   for (unsigned long i = 0; i < frameCount; i += st->hop) {
     unsigned long chunk = std::min<unsigned long>(st->hop, frameCount - i);
@@ -253,11 +376,17 @@ static int audioCb(const void* input, void*, unsigned long frameCount,
     for (unsigned long j = chunk; j < st->hop; ++j)
       fvec_set_sample(st->inputFrame, 0.f, j);
     // aubio outputs pitch (Hz) into an fvec
-    fvec_t* out = new_fvec(1);
-    aubio_pitch_do(st->pitch, st->inputFrame, out);
-    float hz = fvec_get_sample(out, 0);
-    if (hz > 20.f && hz < 2000.f) g_detectedHz.store(hz, std::memory_order_relaxed);
-    del_fvec(out);
+    aubio_pitch_do(st->pitch, st->inputFrame, st->pitchOut);
+    float hz = fvec_get_sample(st->pitchOut, 0);
+    if (hz > 20.f && hz < 2000.f) {
+      g_detectedCentroidHz.store(spectralCentroidHz(in + i, chunk, sr), std::memory_order_relaxed);
+      g_detectedHz.store(hz, std::memory_order_relaxed);
+      if (timed) {
+        // Stamp with the capture time of the end of this hop.
+        double adc = timeInfo->inputBufferAdcTime + double(i + chunk) / sr;
+        g_detectedAtUs.store(st->clock->fromReferenceUs((int64_t)(adc * 1e6)), std::memory_order_relaxed);
+      }
+    }
   }
   return paContinue;
 }
@@ -275,15 +404,81 @@ std::vector<AudioDevice> listAudioDevices() {
 #endif
 
 // --------- SDL2 Render ---------
+// Per-frame vertex buffer for the note highway. Everything is appended as
+// untextured quads with per-vertex colour and submitted with a single
+// SDL_RenderGeometry call, so draw calls stay flat regardless of note density.
+// Storage is kept between frames; clear() only resets the sizes.
+struct GeometryBatch {
+  std::vector<SDL_Vertex> verts;
+  std::vector<int> indices;
+
+  void clear() { verts.clear(); indices.clear(); }
+
+  void quad(SDL_FPoint a, SDL_FPoint b, SDL_FPoint c, SDL_FPoint d, SDL_Color col) {
+    int base = (int)verts.size();
+    verts.push_back(SDL_Vertex{a, col, {0.f, 0.f}});
+    verts.push_back(SDL_Vertex{b, col, {0.f, 0.f}});
+    verts.push_back(SDL_Vertex{c, col, {0.f, 0.f}});
+    verts.push_back(SDL_Vertex{d, col, {0.f, 0.f}});
+    const int idx[6] = {base, base+1, base+2, base, base+2, base+3};
+    indices.insert(indices.end(), idx, idx + 6);
+  }
+
+  void rect(const SDL_Rect& r, SDL_Color col) {
+    float x0 = (float)r.x, y0 = (float)r.y;
+    float x1 = (float)(r.x + r.w), y1 = (float)(r.y + r.h);
+    quad({x0,y0}, {x1,y0}, {x1,y1}, {x0,y1}, col);
+  }
+
+  // One pixel wide line, expanded to a quad along its normal.
+  void line(int x1, int y1, int x2, int y2, SDL_Color col) {
+    float dx = float(x2 - x1), dy = float(y2 - y1);
+    float len = std::sqrt(dx*dx + dy*dy);
+    float nx = 0.f, ny = 0.5f;
+    if (len > 0.f) { nx = -dy / len * 0.5f; ny = dx / len * 0.5f; }
+    float ax = x1 + 0.5f, ay = y1 + 0.5f, bx = x2 + 0.5f, by = y2 + 0.5f;
+    if (len == 0.f) { ax -= 0.5f; bx += 0.5f; }
+    quad({ax+nx, ay+ny}, {bx+nx, by+ny}, {bx-nx, by-ny}, {ax-nx, ay-ny}, col);
+  }
+
+  void flush(SDL_Renderer* r) {
+    if (!indices.empty())
+      SDL_RenderGeometry(r, nullptr, verts.data(), (int)verts.size(),
+                         indices.data(), (int)indices.size());
+    clear();
+  }
+};
+
 struct RenderState {
   SDL_Window* window = nullptr;
   SDL_Renderer* r = nullptr;
   int w = 1280, h = 720;
   SDL_Texture* laneTex = nullptr;  // full-res offscreen
-  SDL_Texture* bloomTex = nullptr; // downsampled bright areas
-  SDL_Texture* blurTex = nullptr;  // blurred result
+  SDL_Texture* bloomTex = nullptr; // downsampled bright areas, blurred
+  // CPU side of the bloom pass (target textures can't be locked, so the
+  // lane pass is read back, processed here and uploaded to bloomTex).
+  std::vector<Uint32> lanePixels;
+  std::vector<Uint32> bloomPixels;
+  std::vector<Uint32> blurPixels;
+  GeometryBatch highway;           // beat lines + notes, rebuilt every frame
+  // Cached static layers: lanes + hit line (under the notes) and the fret
+  // number row (on top of bloom). Rebuilt only when the key below changes.
+  SDL_Texture* backgroundTex = nullptr;
+  SDL_Texture* fretHintTex = nullptr;
+  std::array<SDL_Color,kMaxStrings> layerColors{};
+  int layerW = 0, layerH = 0, layerStrings = 0, layerHitX = -1;
+  bool layersValid = false;
 };
 
+static bool sameColor(const SDL_Color& a, const SDL_Color& b) {
+  return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+}
+
+inline void presentFrame(RenderState& rs) {
+  RT_PROFILE_SCOPE("present");
+  SDL_RenderPresent(rs.r);
+}
+
 inline void drawTextCentered(RenderState& rs, std::string_view text, int y, int scale, SDL_Color col) {
   int w = (int)text.size() * 8 * scale;
   int x = rs.w / 2 - w / 2;
@@ -296,28 +491,331 @@ struct GameplayStats {
   int misses = 0;
   int combo = 0;
   float accuracy = 100.f;
-  std::size_t nextNote = 0; // index of next note to judge
+  int level = kDifficultyLevels - 1; // difficulty layer being judged
+  std::size_t nextNote = 0; // position in that layer of the next note to judge
+  PositionDisambiguator position; // which string a detected pitch was played on
+  DifficultyAdjuster dda; // recent hit rate and timing, for adaptDifficulty
 };
 
+// Judge notes against the detected pitch at song time now_ms. A note becomes
+// judgeable hitWindow ms before its start; it is a hit as soon as a matching
+// pitch is seen inside the window and a miss once the window has passed.
+// At playback rate `rate` the window shrinks in song time so it stays
+// +-100 ms of real time for the player. The string a pitch was played on is
+// chosen with the note's expected position, the hand's recent position and
+// the detection's brightness (centroidHz, 0 if unknown).
+template <class Profile>
+void judgeNotesFor(GameplayStats& stats, const CompiledChart& cc, int64_t now_ms, float hz, double rate,
+                   float centroidHz) {
+  const Chart& chart = *cc.chart;
+  const BasicNoteTable<Profile>& table = g_noteTable<Profile>;
+  const int hitWindow = (int)std::lround(100 * rate); // milliseconds
+  auto det = table.classify(hz);
+  const std::vector<uint32_t>& layer = cc.layer(stats.level);
+  while (stats.nextNote < layer.size()) {
+    const uint32_t i = layer[stats.nextNote];
+    const auto& n = chart.notes[i];
+    if (now_ms < n.t_ms - hitWindow) break; // upcoming note
+    bool hit = false;
+    NotePosition played{-1, -1};
+    // Only the expected pitch can hit; then the position it was played at must match.
+    const CompiledNote& cn = cc.notes[i];
+    if (det && det->midi == cn.midi && std::abs(now_ms - n.t_ms) <= hitWindow) {
+      played = stats.position.choose(table, det->midi, &n, hz, centroidHz);
+      hit = played.stringIdx == cn.lane && played.fret == n.fret;
+    }
+    if (hit) {
+      stats.position.confirm(played, hz, centroidHz);
+      stats.dda.record(true, (now_ms - n.t_ms) / rate);
+      stats.hits++;
+      stats.combo++;
+    } else if (now_ms > n.t_ms + hitWindow) {
+      stats.dda.record(false, 0.0);
+      stats.misses++;
+      stats.combo = 0;
+    } else {
+      break; // still inside its window, keep listening
+    }
+    stats.nextNote++;
+  }
+  int total = stats.hits + stats.misses;
+  stats.accuracy = total ? (float)stats.hits * 100.f / total : 100.f;
+}
+
+// Judge a compiled chart (see CompiledChart::sync) at difficulty stats.level
+// with its instrument profile, whose note table must be current (see
+// setInstrument).
+void judgeNotes(GameplayStats& stats, const CompiledChart& cc, int64_t now_ms, float hz, double rate = 1.0,
+                float centroidHz = 0.f) {
+  withInstrument(cc.strings, [&](auto p) {
+    judgeNotesFor<decltype(p)>(stats, cc, now_ms, hz, rate, centroidHz);
+  });
+}
+
+// Judge difficulty `level` from the next unjudged note on. Only the cursor
+// moves, to the same point in the new layer; results so far are kept.
+void setDifficulty(GameplayStats& stats, const CompiledChart& cc, int level) {
+  level = std::clamp(level, 0, kDifficultyLevels - 1);
+  if (level == stats.level) return;
+  stats.nextNote = cc.remap(stats.nextNote, stats.level, level);
+  stats.level = level;
+  stats.dda.changed();
+}
+
+// Dynamic difficulty, run after judging each tick: once the last note of a
+// phrase has been judged, step one level toward what stats.dda says the
+// player can manage. The new layer is judged from the start of the next
+// phrase, so no phrase mixes levels. O(1) unless the level changes.
+void adaptDifficulty(GameplayStats& stats, const CompiledChart& cc) {
+  const std::vector<uint32_t>& layer = cc.layer(stats.level);
+  if (stats.nextNote == 0 || stats.nextNote >= layer.size()) return;
+  int phrase = cc.notes[layer[stats.nextNote]].phrase;
+  if (phrase == cc.notes[layer[stats.nextNote - 1]].phrase || phrase == stats.dda.decidedPhrase) return;
+  stats.dda.decidedPhrase = phrase;
+  int level = std::clamp(stats.level + stats.dda.verdict(), 0, kDifficultyLevels - 1);
+  if (level == stats.level) return;
+  stats.nextNote = cc.position(level, cc.phraseStarts[phrase]);
+  stats.level = level;
+  stats.dda.changed();
+}
+
+// --------- Fixed-rate simulation ---------
+// State published by the simulation thread for the renderer.
+struct PlaySnapshot {
+  int64_t songMs = 0;  // song time of the last tick, latency offset applied
+  int64_t clockUs = 0; // Clock time the tick was scheduled for
+  double rate = 1.0;   // song ms per clock ms
+  bool playing = true;
+  GameplayStats stats;
+};
+
+// Runs judgement with a fixed 1 ms step, so scoring neither depends on the
+// frame rate nor pauses when a frame takes 50 ms. Ticks are scheduled on an
+// injected Clock: advanceTo() runs every tick due up to a clock time, and
+// start() does that on a thread against the clock. Song time advances in
+// whole ticks while playing. Each tick copies the working snapshot into the
+// published one; the renderer reads that copy and extrapolates from its
+// clock stamp. With a ManualClock the whole run is deterministic.
+struct Simulation {
+  static constexpr int64_t kTickUs = 1000;
+  static constexpr int64_t kMaxDetectionAgeUs = 50000; // older stamps are stale holds
+
+  const Chart* chart = nullptr;
+  CompiledChart compiled;     // judgement attributes of chart, built by reset()
+  const Clock* clock = nullptr;
+  const BackingTrack* track = nullptr; // when set, song time follows its output position
+  std::thread thread;
+  std::atomic<bool> running{false};
+  std::atomic<bool> playing{true};
+  std::atomic<double> rate{1.0}; // playback rate, slow-down practice
+  std::atomic<int> level{kDifficultyLevels - 1}; // difficulty to switch to on the next tick, -1 once applied
+  std::atomic<bool> adaptive{false}; // let adaptDifficulty change the level between phrases
+  SessionWriter* recorder = nullptr;  // when set, every tick's inputs are logged
+  SessionReplay* replay = nullptr;    // when set, inputs come from a log instead
+  std::atomic<bool> replayDone{false}; // the log has run out
+  int64_t songUs = 0;
+  int64_t nextTickUs = 0;     // clock time of the next tick
+  TimeAnchor song;            // song time (us) at clock time, for the audio callback
+  PlaySnapshot back;          // owned by the simulation thread
+  mutable std::mutex mtx;
+  PlaySnapshot front;         // published copy, guarded by mtx
+
+  ~Simulation() { stop(); }
+
+  // Start a fresh run of chart at song time 0, first tick one step from now.
+  void reset(const Chart& c, bool play, const Clock& clk) {
+    chart = &c;
+    compiled.sync(c);
+    clock = &clk;
+    songUs = 0;
+    playing.store(play, std::memory_order_relaxed);
+    nextTickUs = clk.nowUs() + kTickUs;
+    back = PlaySnapshot{};
+    replayDone.store(false);
+    back.clockUs = clk.nowUs();
+    back.playing = play;
+    song.publish(back.clockUs, 0, 0.0);
+    std::lock_guard<std::mutex> lk(mtx);
+    front = back;
+  }
+
+  // Everything tick tickUs reads from outside the simulation: the UI's
+  // controls, latency settings, the detector and the backing track, or the
+  // same from a replayed log. A requested level is handed over once, so it
+  // doesn't undo adaptive changes.
+  TickInput input(int64_t tickUs) {
+    if (replay) {
+      TickInput in = replay->next(tickUs);
+      if (replay->finished()) replayDone.store(true, std::memory_order_relaxed);
+      return in;
+    }
+    TickInput in;
+    in.playing = playing.load(std::memory_order_relaxed);
+    in.rate = rate.load(std::memory_order_relaxed);
+    in.level = level.exchange(-1, std::memory_order_relaxed);
+    in.adaptive = adaptive.load(std::memory_order_relaxed);
+    in.latencyOffsetMs = g_latencyOffsetMs.load(std::memory_order_relaxed);
+    in.audioOffsetMs = g_audioOffsetMs.load(std::memory_order_relaxed);
+    in.hz = g_detectedHz.load(std::memory_order_relaxed);
+    in.centroidHz = g_detectedCentroidHz.load(std::memory_order_relaxed);
+    in.detectedAtUs = g_detectedAtUs.load(std::memory_order_relaxed);
+    in.hasTrack = track != nullptr;
+    in.trackUs = track ? track->songUsAt(tickUs) : -1;
+    return in;
+  }
+
+  // Advance one tick scheduled at clock time tickUs and publish the result.
+  // A fresh detection is judged at the song time its audio was captured, not
+  // the (slightly later) tick that sees it, less the calibrated audio offset.
+  // The tick depends only on its input and the previous ticks, which is what
+  // makes a recorded session replay exactly.
+  void step(int64_t tickUs) {
+    RT_PROFILE_SCOPE("sim.step");
+    const TickInput in = input(tickUs);
+    if (recorder) recorder->record(in, tickUs);
+    const bool play = in.playing;
+    const double r = in.rate;
+    if (play) {
+      // With a backing track the song waits for its audio to start and then
+      // runs at the position being heard (never backwards).
+      if (in.hasTrack) songUs = std::max(songUs, in.trackUs);
+      else songUs += std::llround(kTickUs * r);
+    }
+    // The audio callback extrapolates from here; a playing track's own
+    // position is exact to the sample, so it is passed on as is.
+    TimeAnchor::Value tv = track ? track->pos.load() : TimeAnchor::Value{};
+    if (play && tv.valid && tv.rate > 0.0) song.publish(tv.fromUs, tv.toUs, tv.rate);
+    else song.publish(tickUs, songUs, play && !in.hasTrack ? r : 0.0);
+    back.songMs = songUs / 1000 + in.latencyOffsetMs;
+    back.playing = play;
+    back.clockUs = tickUs;
+    back.rate = r;
+    if (in.level >= 0) setDifficulty(back.stats, compiled, in.level);
+    if (play) {
+      // Detection age and the audio offset are real time; scale to song time.
+      int64_t lateUs = in.audioOffsetMs * 1000;
+      int64_t detUs = in.detectedAtUs;
+      if (detUs > 0 && tickUs >= detUs && tickUs - detUs < kMaxDetectionAgeUs)
+        lateUs += tickUs - detUs;
+      int64_t judgedMs = back.songMs - std::llround(lateUs * r / 1000.0);
+      judgeNotes(back.stats, compiled, judgedMs, in.hz, r, in.centroidHz);
+      if (in.adaptive) adaptDifficulty(back.stats, compiled);
+    }
+    std::lock_guard<std::mutex> lk(mtx);
+    front = back;
+  }
+
+  // Run every tick due at or before clock time nowUs.
+  void advanceTo(int64_t nowUs) {
+    while (nextTickUs <= nowUs) {
+      step(nextTickUs);
+      nextTickUs += kTickUs;
+    }
+  }
+
+  void start(const Chart& c, bool play, const Clock& clk) {
+    stop();
+    reset(c, play, clk);
+    running.store(true);
+    thread = std::thread([this]{
+      Profiler::instance().setThreadName("simulation");
+      while (running.load(std::memory_order_relaxed)) {
+        int64_t now = clock->nowUs();
+        advanceTo(now);
+        // Sleep until roughly the next tick (assuming a real-time clock;
+        // faster clocks simply run several ticks per wake-up).
+        std::this_thread::sleep_for(std::chrono::microseconds(
+          std::clamp<int64_t>(nextTickUs - clock->nowUs(), 0, kTickUs)));
+      }
+    });
+  }
+
+  void stop() {
+    running.store(false);
+    if (thread.joinable()) thread.join();
+    song.invalidate();
+  }
+
+  PlaySnapshot snapshot() const {
+    std::lock_guard<std::mutex> lk(mtx);
+    return front;
+  }
+};
+
+// Judge a recorded session again from the start, as fast as possible, on a
+// manual clock. The chart (and its instrument) must be the one it was
+// recorded on; see chartHash.
+GameplayStats replaySession(const Chart& chart, SessionReplay& log) {
+  ManualClock clock;
+  Simulation sim;
+  sim.replay = &log;
+  log.rewind();
+  sim.reset(chart, true, clock);
+  while (!sim.replayDone.load()) {
+    clock.advanceUs(Simulation::kTickUs);
+    sim.advanceTo(clock.nowUs());
+  }
+  return sim.snapshot().stats;
+}
+
 // --------- App State Machine ---------
-enum class AppState { Title, Library, Tuner, FreePlay, Settings, Play };
+enum class AppState { Title, Library, Tuner, FreePlay, Settings, Calibrate, Play };
 
 struct App {
   RenderState rs;
   Chart chart;
+  CompiledChart compiled; // per-note render/judge attributes of chart, UI thread
+  VisibleRange visible;   // notes on the highway last frame
   SettingsState settings;
   AppState state = AppState::Title;
   int menuIndex = 0; // index into title menu
   bool running = true;
   bool playing = true; // used in Play state
-  std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
-  GameplayStats stats; // hit/miss tracking
+  double playbackRate = 1.0; // slow-down practice, 0.5..1.0
+  SteadyClock steadyClock;
+  SyncedClock audioClock{steadyClock}; // steady_clock slaved to the audio stream
+  const Clock* clock = &audioClock;    // time source for play state; swap for tests/replay
+  Simulation sim;      // judgement thread, runs while in Play state
+  SessionWriter recorder; // this Play session's log, with settings.recordSessions
+  Calibrator calib;    // latency calibration, Calibrate state
+  BackingTrack track;  // the chart's backing audio, if any
+  Metronome metronome; // click track, mixed by the audio callback
+  GameplayStats stats; // hit/miss tracking, copied from the sim each frame
   std::array<float, kFrameHistory> frameTimes{};
+  FrameStats frameStats; // whole-session histogram behind the F3 percentiles
   int frameTimeIdx = 0;
   bool frameTimesFull = false;
   bool showFrameGraph = false;
+  std::vector<PhaseTime> phaseTimes; // profiler summary of the previous frame
+  uint64_t frameStartNs = 0;
+  // Damage tracking for non-play screens: they only re-render when this is
+  // set (input, state change, tuner pitch change).
+  bool redraw = true;
+  float drawnHz = 0.0f; // pitch shown by the last tuner frame
 };
 
+// Offscreen textures used by drawChart. Split from initSDL so headless
+// renderers (tests, benchmarks) can set them up too.
+bool createRenderTargets(RenderState& rs) {
+  rs.laneTex = SDL_CreateTexture(rs.r, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, rs.w, rs.h);
+  int bw = rs.w/2, bh = rs.h/2;
+  rs.bloomTex = SDL_CreateTexture(rs.r, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STREAMING, bw, bh);
+  if (!rs.laneTex || !rs.bloomTex) {
+    std::cerr << "Texture creation failed\n"; return false;
+  }
+  return true;
+}
+
+void destroyRenderTargets(RenderState& rs) {
+  if (rs.fretHintTex) SDL_DestroyTexture(rs.fretHintTex);
+  if (rs.backgroundTex) SDL_DestroyTexture(rs.backgroundTex);
+  if (rs.bloomTex) SDL_DestroyTexture(rs.bloomTex);
+  if (rs.laneTex) SDL_DestroyTexture(rs.laneTex);
+  rs.fretHintTex = rs.backgroundTex = rs.bloomTex = rs.laneTex = nullptr;
+  rs.layersValid = false;
+  rs.layerW = rs.layerH = 0;
+}
+
 bool initSDL(RenderState& rs, const SettingsState& settings) {
   SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "1");
   if (SDL_Init(SDL_INIT_VIDEO|SDL_INIT_EVENTS|SDL_INIT_TIMER) != 0) {
@@ -331,43 +829,14 @@ bool initSDL(RenderState& rs, const SettingsState& settings) {
   if (settings.vsync) flags |= SDL_RENDERER_PRESENTVSYNC;
   rs.r = SDL_CreateRenderer(rs.window, -1, flags);
   if (!rs.r) { std::cerr << "SDL_CreateRenderer failed\n"; return false; }
-  // Create render targets
-  rs.laneTex = SDL_CreateTexture(rs.r, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, rs.w, rs.h);
-  int bw = rs.w/2, bh = rs.h/2;
-  rs.bloomTex = SDL_CreateTexture(rs.r, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, bw, bh);
-  rs.blurTex  = SDL_CreateTexture(rs.r, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, bw, bh);
-  if (!rs.laneTex || !rs.bloomTex || !rs.blurTex) {
-    std::cerr << "Texture creation failed\n"; return false;
-  }
-  return true;
+  return createRenderTargets(rs);
 }
 
 // Update gameplay stats based on detected frequency and current time
 void updateGameplay(App& app, int64_t now_ms) {
-  const int hitWindow = 100; // milliseconds
-  float hz = g_detectedHz.load(std::memory_order_relaxed);
-  auto det = analyzeFrequency(hz);
-  while (app.stats.nextNote < app.chart.notes.size()) {
-    const auto& n = app.chart.notes[app.stats.nextNote];
-    if (now_ms < n.t_ms - hitWindow) break; // upcoming note
-    bool hit = false;
-    if (det && std::abs(now_ms - n.t_ms) <= hitWindow) {
-      if (det->stringIdx >= 0 && det->fret >= 0) {
-        int detStr = 6 - det->stringIdx; // convert back to 1..6
-        if (detStr == n.str && det->fret == n.fret) hit = true;
-      }
-    }
-    if (hit) {
-      app.stats.hits++;
-      app.stats.combo++;
-    } else {
-      app.stats.misses++;
-      app.stats.combo = 0;
-    }
-    app.stats.nextNote++;
-  }
-  int total = app.stats.hits + app.stats.misses;
-  app.stats.accuracy = total ? (float)app.stats.hits * 100.f / total : 100.f;
+  app.compiled.sync(app.chart);
+  judgeNotes(app.stats, app.compiled, now_ms, g_detectedHz.load(std::memory_order_relaxed), 1.0,
+             g_detectedCentroidHz.load(std::memory_order_relaxed));
 }
 
 void renderFrameGraph(App& app) {
@@ -399,180 +868,295 @@ void renderFrameGraph(App& app) {
     int y2 = y0 + h - int(t1 * scale);
     SDL_RenderDrawLine(r, x1, y1, x2, y2);
   }
-}
 
-// Render the play state (chart + tuner overlay)
-// Uses data from the app to draw the current chart at the given time.
-void drawChart(App& app, const Chart* chart, int64_t now_ms) {
-  RenderState& rs = app.rs;
-  const SettingsState& settings = app.settings;
-  const GameplayStats& stats = app.stats;
+  // Session percentiles
+  const FrameStats& fst = app.frameStats;
+  char statBuf[96];
+  std::snprintf(statBuf, sizeof(statBuf), "p50 %.1f  p95 %.1f  p99 %.1f  max %.1f ms  drop %llu/%llu",
+                fst.percentile(50), fst.percentile(95), fst.percentile(99), fst.maxMs(),
+                (unsigned long long)fst.dropped, (unsigned long long)fst.total);
+  drawText(r, statBuf, x0 + w + 10, y0, 1, SDL_Color{200,200,220,255});
+#ifdef RT_ENABLE_AUDIO
+  const AudioStats& as = g_audioStats;
+  std::snprintf(statBuf, sizeof(statBuf), "audio cb %.0f us  p99 %u  max %u  xruns %llu  lat %.1f/%.1f ms",
+                as.meanUs(), as.percentileUs(99), as.maxUs.load(std::memory_order_relaxed),
+                (unsigned long long)as.xruns(), as.requestedLatencyMs, as.inputLatencyMs);
+  drawText(r, statBuf, x0 + w + 10, y0 + 12, 1,
+           as.xruns() ? SDL_Color{255,120,120,255} : SDL_Color{200,200,220,255});
+#endif
 
-  // First pass: render chart to offscreen texture
-  SDL_SetRenderTarget(rs.r, rs.laneTex);
+  // Per-phase bars for the previous frame (profiler scopes), 12 px per ms.
+  const int rowH = 10;
+  const int barX = x0 + 160;
+  int py = y0 + h + 6;
+  if (!app.phaseTimes.empty()) {
+    SDL_SetRenderDrawColor(r, 0, 0, 0, 160);
+    SDL_Rect pbg{ x0-1, py-2, 160 + 220, (int)app.phaseTimes.size()*rowH + 4 };
+    SDL_RenderFillRect(r, &pbg);
+  }
+  for (const PhaseTime& p : app.phaseTimes) {
+    char buf[48];
+    std::snprintf(buf, sizeof(buf), "%-14.14s %5.2f", p.name, p.ms);
+    drawText(r, buf, x0, py + 1, 1, SDL_Color{200,200,220,255});
+    int bw = std::min(200, (int)(p.ms * 12.0));
+    SDL_SetRenderDrawColor(r, p.ms > 8.0 ? 255 : 0, p.ms > 8.0 ? 80 : 200, 80, 255);
+    SDL_Rect bar{ barX, py + 1, std::max(1, bw), rowH - 2 };
+    SDL_RenderFillRect(r, &bar);
+    py += rowH;
+  }
+}
+
+// --------- Static highway layers ---------
+// Colored lanes, one per string (lowest at the bottom; on a six-string low E
+// → purple, high E top → red), and the hit line at hitX.
+void drawBackgroundLayer(RenderState& rs, const SettingsState& settings, int strings, int hitX) {
   SDL_SetRenderDrawColor(rs.r, 12,12,16,255);
   SDL_RenderClear(rs.r);
-
-  // Colored lanes (low E bottom → purple, high E top → red)
-  int laneH = rs.h / 8;
+  int laneH = rs.h / (strings + 2);
   int topOffset = laneH; // top margin
-  for (int s = 0; s < 6; ++s) {
+  for (int s = 0; s < strings; ++s) {
     int y = rs.h - topOffset - s*laneH;
-    SDL_Color c = settings.stringColors[s];
+    SDL_Color c = settings.stringColors[stringColorIndex(strings - s)];
     SDL_SetRenderDrawColor(rs.r, c.r/4, c.g/4, c.b/4, 255);
     SDL_Rect lane{ 0, y - laneH/2, rs.w, laneH-2 };
     SDL_RenderFillRect(rs.r, &lane);
   }
 
-  // Hit line at center
+  // Hit line
   SDL_SetRenderDrawColor(rs.r, 255,255,255,120);
-  SDL_RenderDrawLine(rs.r, rs.w/2, topOffset/2, rs.w/2, rs.h-topOffset/2);
+  SDL_RenderDrawLine(rs.r, hitX, topOffset/2, hitX, rs.h-topOffset/2);
+}
+
+// The fret number row: a strip of text kFretHintScale * 8 px high along the bottom.
+constexpr int kFretHintScale = 1;
+SDL_Rect fretHintRect(const RenderState& rs) {
+  return SDL_Rect{0, rs.h - 12 * kFretHintScale - 4, rs.w, 8 * kFretHintScale};
+}
+
+// Fret number hints with their top at baseY, drawn over whatever the target holds.
+void drawFretHintLayer(RenderState& rs, int baseY) {
+  const int fretScale = kFretHintScale;
+  int spacing = rs.w / (kMaxFrets + 1);
+  for (int i = 0; i <= kMaxFrets; ++i) {
+    char buf[4];
+    snprintf(buf, sizeof(buf), "%d", i);
+    int x = i * spacing + 5;
+    drawText(rs.r, buf, x, baseY, fretScale, SDL_Color{120,120,140,255});
+  }
+}
+
+// Re-render the cached layers if the string colours or count, the hit line
+// or the size changed since the last build. Leaves the caller's render target bound. If the
+// renderer can't create target textures the layer pointers stay null and
+// drawChart falls back to drawing directly.
+void updateStaticLayers(RenderState& rs, const SettingsState& settings, int strings, int hitX) {
+  bool valid = rs.layersValid && rs.layerW == rs.w && rs.layerH == rs.h && rs.layerStrings == strings &&
+               rs.layerHitX == hitX;
+  for (int s = 0; valid && s < kMaxStrings; ++s)
+    valid = sameColor(rs.layerColors[s], settings.stringColors[s]);
+  if (valid) return;
+
+  if (rs.layerW != rs.w || rs.layerH != rs.h) {
+    if (rs.backgroundTex) SDL_DestroyTexture(rs.backgroundTex);
+    if (rs.fretHintTex) SDL_DestroyTexture(rs.fretHintTex);
+    rs.backgroundTex = SDL_CreateTexture(rs.r, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, rs.w, rs.h);
+    SDL_Rect hint = fretHintRect(rs);
+    rs.fretHintTex = SDL_CreateTexture(rs.r, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, hint.w, hint.h);
+    if (rs.backgroundTex) SDL_SetTextureBlendMode(rs.backgroundTex, SDL_BLENDMODE_NONE);
+    if (rs.fretHintTex) SDL_SetTextureBlendMode(rs.fretHintTex, SDL_BLENDMODE_BLEND);
+  }
+
+  SDL_Texture* prev = SDL_GetRenderTarget(rs.r);
+  if (rs.backgroundTex) {
+    SDL_SetRenderTarget(rs.r, rs.backgroundTex);
+    drawBackgroundLayer(rs, settings, strings, hitX);
+  }
+  if (rs.fretHintTex) {
+    SDL_SetRenderTarget(rs.r, rs.fretHintTex);
+    SDL_SetRenderDrawColor(rs.r, 0,0,0,0);
+    SDL_RenderClear(rs.r);
+    drawFretHintLayer(rs, 0);
+  }
+  SDL_SetRenderTarget(rs.r, prev);
+
+  rs.layerColors = settings.stringColors;
+  rs.layerW = rs.w;
+  rs.layerH = rs.h;
+  rs.layerStrings = strings;
+  rs.layerHitX = hitX;
+  rs.layersValid = true;
+}
+
+// Render the play state (chart + tuner overlay)
+// Uses data from the app to draw the current chart at the given time.
+void drawChart(App& app, const Chart* chart, int64_t now_ms) {
+  RenderState& rs = app.rs;
+  const SettingsState& settings = app.settings;
+  const GameplayStats& stats = app.stats;
+  const int strings = chart ? chart->strings : 6;
+  // Speed and look-ahead are read every frame, so changing them mid-song
+  // takes effect on the next one.
+  const HighwayView view(rs.w, settings.scrollSpeed, settings.lookAheadMs);
+  const int hitX = (int)view.hitX;
+
+  // First pass: render chart to offscreen texture
+  {
+    RT_PROFILE_SCOPE("chart.background");
+    SDL_SetRenderTarget(rs.r, rs.laneTex);
+    updateStaticLayers(rs, settings, strings, hitX);
+    if (rs.backgroundTex) {
+      SDL_RenderCopy(rs.r, rs.backgroundTex, nullptr, nullptr);
+    } else {
+      drawBackgroundLayer(rs, settings, strings, hitX);
+    }
+  }
+
+  int laneH = rs.h / (strings + 2);
+  int topOffset = laneH; // top margin
 
   if (chart) {
-    const double windowMs = 4000.0;
-    double beatMs = 60000.0 / chart->bpm;
-    double measureMs = beatMs * 4.0;
-    int64_t startBeat = (int64_t)std::floor((now_ms - windowMs) / beatMs) * (int64_t)beatMs;
-    int64_t endTime = now_ms + (int64_t)windowMs;
-    for (double t = startBeat; t <= endTime; t += beatMs) {
-      double dtb = t - now_ms;
-      double x = (dtb / windowMs) * rs.w * 0.9 + rs.w*0.5;
-      if (x < 0 || x > rs.w) continue;
-      bool isMeasure = std::fmod(t, measureMs) < 1.0;
-      SDL_SetRenderDrawColor(rs.r, 255,255,255, isMeasure ? 100 : 40);
-      SDL_RenderDrawLine(rs.r, (int)x, topOffset/2, (int)x, rs.h-topOffset/2);
-    }
-
-    for (const auto& n : chart->notes) {
+    RT_PROFILE_SCOPE("chart.highway");
+    GeometryBatch& batch = rs.highway;
+    batch.clear();
+    const int64_t fromMs = now_ms - (int64_t)std::ceil(view.behindMs);
+    const int64_t toMs = now_ms + (int64_t)std::ceil(view.aheadMs);
+    // Beat lines from the tempo map, brighter on the first beat of a bar.
+    TempoMap(*chart).forEachBeat(fromMs * 1000, (toMs + 1) * 1000,
+      [&](int64_t us, bool downbeat) {
+        double dtb = (double)us / 1000.0 - (double)now_ms;
+        double x = view.x(dtb);
+        if (x < 0 || x > rs.w) return;
+        batch.line((int)x, topOffset/2, (int)x, rs.h-topOffset/2,
+                   SDL_Color{255,255,255, (Uint8)(downbeat ? 100 : 40)});
+      });
+
+    // Lane, colour, sustain length and slide offset come precomputed; pitch
+    // attributes are only recompiled when the chart or its tuning changes,
+    // and pixel ones as notes come on screen after a zoom or lane size
+    // change. Only the notes of the judged difficulty layer in the window
+    // are visited.
+    CompiledChart& cc = app.compiled;
+    if (cc.sync(*chart)) app.visible = VisibleRange{};
+    cc.layout(view.pxPerMs, laneH / 24.0);
+    const std::vector<uint32_t>& layer = cc.layer(stats.level);
+    app.visible.update(chart->notes, layer, fromMs, toMs);
+    for (std::size_t p = app.visible.first; p < app.visible.last; ++p) {
+      const uint32_t i = layer[p];
+      const NoteEvent& n = chart->notes[i];
+      const CompiledNote& cn = cc.placed(i);
       double dt = (double)(n.t_ms - now_ms);
-      if (dt < -2000 || dt > windowMs) continue;
-      double x = (dt / windowMs) * rs.w * 0.9 + rs.w*0.5;
-      int sIdx = std::clamp(6 - n.str, 0, 5);
-      int y = rs.h - topOffset - sIdx*laneH;
-      double depth = std::clamp(1.0 - std::abs(dt)/windowMs, 0.0, 1.0);
+      double x = view.x(dt);
+      int y = rs.h - topOffset - cn.lane*laneH;
+      double depth = view.depth(dt);
       double scale = 0.5 + 0.5*depth;
       Uint8 alpha = (Uint8)(255 * depth);
       int h = (int)(laneH/2 * scale);
-      int w = std::max(12, (int)((n.len_ms/windowMs) * rs.w * 0.9));
+      int w = std::max(12, (int)cn.lenPx);
       int headW = std::max(12, (int)(12 * scale));
       int sustainW = w - headW;
 
-      SDL_Color c = settings.stringColors[sIdx];
-      SDL_SetRenderDrawColor(rs.r, c.r, c.g, c.b, alpha);
+      SDL_Color c = settings.stringColors[cn.colorIdx];
+      c.a = alpha;
       SDL_Rect head{ (int)x - headW/2, y - h/2, headW, h };
-      SDL_RenderFillRect(rs.r, &head);
+      batch.rect(head, c);
       if (sustainW > 0) {
         SDL_Rect sus{ head.x + headW, y - h/4, sustainW, h/2 };
-        SDL_RenderFillRect(rs.r, &sus);
-        if (n.slideTo >= 0 && n.slideTo != n.fret) {
-          double dy = (n.slideTo - n.fret) * (laneH/24.0);
-          SDL_RenderDrawLine(rs.r, head.x + headW, y, head.x + headW + sustainW, (int)(y + dy));
-        }
+        batch.rect(sus, c);
+        if (cn.slideDy != 0.f)
+          batch.line(head.x + headW, y, head.x + headW + sustainW, (int)(y + cn.slideDy), c);
       }
       if (!n.techs.empty()) {
-        SDL_SetRenderDrawColor(rs.r, 255,255,255, alpha);
         SDL_Rect tag{ head.x - 6, head.y - 10, 12, 8 };
-        SDL_RenderFillRect(rs.r, &tag);
+        batch.rect(tag, SDL_Color{255,255,255, alpha});
       }
     }
+    // All highway geometry shares the renderer's draw blend mode, so a single
+    // submission covers it.
+    batch.flush(rs.r);
   }
 
-  // Bloom: extract bright areas to downsampled texture
+  // Bloom: read back the lane pass (still the render target) and extract
+  // bright areas into a half-res buffer. Pixels are RGBA8888: R in the top byte.
+  int bw = rs.w/2, bh = rs.h/2;
   auto extractBright = [&](Uint8 threshold){
-    void* srcPixels; int srcPitch;
-    void* dstPixels; int dstPitch;
-    SDL_LockTexture(rs.laneTex, nullptr, &srcPixels, &srcPitch);
-    SDL_LockTexture(rs.bloomTex, nullptr, &dstPixels, &dstPitch);
-    SDL_PixelFormat* fmt = SDL_AllocFormat(SDL_PIXELFORMAT_RGBA8888);
-    int sw = rs.w, sh = rs.h;
-    int dw = sw/2, dh = sh/2;
-    Uint32* src = static_cast<Uint32*>(srcPixels);
-    Uint32* dst = static_cast<Uint32*>(dstPixels);
-    int sStride = srcPitch/4;
-    int dStride = dstPitch/4;
-    for (int y=0;y<dh;++y){
-      for (int x=0;x<dw;++x){
+    int sw = rs.w;
+    rs.lanePixels.resize((size_t)rs.w * rs.h);
+    rs.bloomPixels.resize((size_t)bw * bh);
+    SDL_RenderReadPixels(rs.r, nullptr, SDL_PIXELFORMAT_RGBA8888, rs.lanePixels.data(), sw*4);
+    const Uint32* src = rs.lanePixels.data();
+    Uint32* dst = rs.bloomPixels.data();
+    for (int y=0;y<bh;++y){
+      for (int x=0;x<bw;++x){
         int r=0,g=0,b=0;
         for(int oy=0;oy<2;++oy) for(int ox=0;ox<2;++ox){
-          Uint8 pr,pg,pb,pa;
-          SDL_GetRGBA(src[(y*2+oy)*sStride + (x*2+ox)], fmt, &pr,&pg,&pb,&pa);
-          r+=pr; g+=pg; b+=pb;
+          Uint32 p = src[(y*2+oy)*sw + (x*2+ox)];
+          r += (p>>24)&0xFF; g += (p>>16)&0xFF; b += (p>>8)&0xFF;
         }
         r/=4; g/=4; b/=4;
         Uint8 bright = (Uint8)((r+g+b)/3);
         if (bright < threshold) r=g=b=0;
-        dst[y*dStride+x] = SDL_MapRGBA(fmt,(Uint8)r,(Uint8)g,(Uint8)b,255);
+        dst[y*bw+x] = (Uint32(r)<<24) | (Uint32(g)<<16) | (Uint32(b)<<8) | 0xFF;
       }
     }
-    SDL_UnlockTexture(rs.laneTex);
-    SDL_UnlockTexture(rs.bloomTex);
-    SDL_FreeFormat(fmt);
   };
 
+  // Separable 5-tap blur (horizontal into blurPixels, vertical back into
+  // bloomPixels), then upload to bloomTex.
   auto blur = [&](){
-    int w = rs.w/2, h = rs.h/2;
+    int w = bw, h = bh;
     const int k[5] = {1,4,6,4,1};
-    SDL_PixelFormat* fmt = SDL_AllocFormat(SDL_PIXELFORMAT_RGBA8888);
-    // horizontal
-    void* srcPix; int srcPitch; void* dstPix; int dstPitch;
-    SDL_LockTexture(rs.bloomTex, nullptr, &srcPix, &srcPitch);
-    SDL_LockTexture(rs.blurTex,  nullptr, &dstPix, &dstPitch);
-    Uint32* src = static_cast<Uint32*>(srcPix); int sStride = srcPitch/4;
-    Uint32* dst = static_cast<Uint32*>(dstPix); int dStride = dstPitch/4;
+    rs.blurPixels.resize((size_t)w * h);
+    const Uint32* src = rs.bloomPixels.data();
+    Uint32* dst = rs.blurPixels.data();
     for(int y=0;y<h;++y){
       for(int x=0;x<w;++x){
         int sr=0,sg=0,sb=0;
         for(int i=-2;i<=2;++i){
-          int sx = std::clamp(x+i,0,w-1);
-          Uint8 r,g,b,a; SDL_GetRGBA(src[y*sStride+sx], fmt,&r,&g,&b,&a);
-          int wgt = k[i+2]; sr+=r*wgt; sg+=g*wgt; sb+=b*wgt;
+          Uint32 p = src[y*w + std::clamp(x+i,0,w-1)];
+          int wgt = k[i+2]; sr+=((p>>24)&0xFF)*wgt; sg+=((p>>16)&0xFF)*wgt; sb+=((p>>8)&0xFF)*wgt;
         }
-        dst[y*dStride+x] = SDL_MapRGBA(fmt, (Uint8)(sr/16), (Uint8)(sg/16), (Uint8)(sb/16), 255);
+        dst[y*w+x] = (Uint32(sr/16)<<24) | (Uint32(sg/16)<<16) | (Uint32(sb/16)<<8) | 0xFF;
       }
     }
-    SDL_UnlockTexture(rs.bloomTex);
-    SDL_UnlockTexture(rs.blurTex);
-    // vertical back into bloomTex
-    SDL_LockTexture(rs.blurTex,  nullptr, &srcPix, &srcPitch);
-    SDL_LockTexture(rs.bloomTex, nullptr, &dstPix, &dstPitch);
-    src = static_cast<Uint32*>(srcPix); sStride = srcPitch/4;
-    dst = static_cast<Uint32*>(dstPix); dStride = dstPitch/4;
+    src = rs.blurPixels.data();
+    dst = rs.bloomPixels.data();
     for(int y=0;y<h;++y){
       for(int x=0;x<w;++x){
         int sr=0,sg=0,sb=0;
         for(int i=-2;i<=2;++i){
-          int sy = std::clamp(y+i,0,h-1);
-          Uint8 r,g,b,a; SDL_GetRGBA(src[sy*sStride+x], fmt,&r,&g,&b,&a);
-          int wgt = k[i+2]; sr+=r*wgt; sg+=g*wgt; sb+=b*wgt;
+          Uint32 p = src[std::clamp(y+i,0,h-1)*w + x];
+          int wgt = k[i+2]; sr+=((p>>24)&0xFF)*wgt; sg+=((p>>16)&0xFF)*wgt; sb+=((p>>8)&0xFF)*wgt;
         }
-        dst[y*dStride+x] = SDL_MapRGBA(fmt, (Uint8)(sr/16), (Uint8)(sg/16), (Uint8)(sb/16), 255);
+        dst[y*w+x] = (Uint32(sr/16)<<24) | (Uint32(sg/16)<<16) | (Uint32(sb/16)<<8) | 0xFF;
       }
     }
-    SDL_UnlockTexture(rs.blurTex);
-    SDL_UnlockTexture(rs.bloomTex);
-    SDL_FreeFormat(fmt);
+    SDL_UpdateTexture(rs.bloomTex, nullptr, rs.bloomPixels.data(), w*4);
   };
 
-  extractBright(200);
-  blur();
-
-  SDL_SetRenderTarget(rs.r, nullptr);
-  SDL_SetRenderDrawColor(rs.r,0,0,0,255);
-  SDL_RenderClear(rs.r);
-  SDL_RenderCopy(rs.r, rs.laneTex, nullptr, nullptr);
-  SDL_SetTextureBlendMode(rs.bloomTex, SDL_BLENDMODE_ADD);
-  SDL_RenderCopy(rs.r, rs.bloomTex, nullptr, nullptr);
+  { RT_PROFILE_SCOPE("chart.bloom.extract"); extractBright(200); }
+  { RT_PROFILE_SCOPE("chart.bloom.blur"); blur(); }
+
+  {
+    RT_PROFILE_SCOPE("chart.composite");
+    SDL_SetRenderTarget(rs.r, nullptr);
+    SDL_SetRenderDrawColor(rs.r,0,0,0,255);
+    SDL_RenderClear(rs.r);
+    SDL_RenderCopy(rs.r, rs.laneTex, nullptr, nullptr);
+    SDL_SetTextureBlendMode(rs.bloomTex, SDL_BLENDMODE_ADD);
+    SDL_RenderCopy(rs.r, rs.bloomTex, nullptr, nullptr);
+  }
 
   // Detected note overlay
   float hz = g_detectedHz.load(std::memory_order_relaxed);
   if (hz > 0.0f) {
+    RT_PROFILE_SCOPE("chart.pitch");
     auto dn = analyzeFrequency(hz);
     if (dn) {
       auto [name, octave] = midiToName(dn->midi);
       char buf[128];
       snprintf(buf, sizeof(buf), "Hz: %.1f  %s%d  %+0.1f cents  %s",
                hz, name.c_str(), octave, dn->cents,
-               (dn->fret >= 0 && dn->stringIdx >= 0) ? ("S" + std::to_string(6-dn->stringIdx) + " F" + std::to_string(dn->fret)).c_str()
+               (dn->fret >= 0 && dn->stringIdx >= 0) ? ("S" + std::to_string(strings-dn->stringIdx) + " F" + std::to_string(dn->fret)).c_str()
                                                      : "—");
       // crude text: draw as rectangles for now (placeholder)
       // You can replace with SDL_ttf later. For now, draw a small bar proportional to pitch.
@@ -590,32 +1174,42 @@ void drawChart(App& app, const Chart* chart, int64_t now_ms) {
     }
   }
 
-  // Draw song title at top-left
-  if (chart) {
-    drawText(rs.r, chart->title, 10, 10, 2, SDL_Color{200,200,220,255});
-  }
+  {
+    RT_PROFILE_SCOPE("chart.text");
+    // Draw song title at top-left
+    if (chart) {
+      drawText(rs.r, chart->title, 10, 10, 2, SDL_Color{200,200,220,255});
+    }
 
-  // Draw combo and accuracy at top-right
-  char statsBuf[64];
-  snprintf(statsBuf, sizeof(statsBuf), "Combo %d  Acc %.1f%%", stats.combo, stats.accuracy);
-  int scale = 2;
-  int statsW = (int)std::strlen(statsBuf) * 8 * scale;
-  drawText(rs.r, statsBuf, rs.w - statsW - 10, 10, scale, SDL_Color{200,200,220,255});
+    // Draw combo and accuracy at top-right
+    char statsBuf[80];
+    char levelBuf[16] = "";
+    const char* levelName = kDifficultyNames[std::clamp(stats.level, 0, kDifficultyLevels - 1)];
+    if (settings.adaptiveDifficulty)
+      snprintf(levelBuf, sizeof(levelBuf), "Auto %s  ", levelName);
+    else if (stats.level != kDifficultyLevels - 1)
+      snprintf(levelBuf, sizeof(levelBuf), "%s  ", levelName);
+    if (app.playbackRate != 1.0)
+      snprintf(statsBuf, sizeof(statsBuf), "%s%d%%  Combo %d  Acc %.1f%%", levelBuf,
+               (int)std::lround(app.playbackRate * 100), stats.combo, stats.accuracy);
+    else
+      snprintf(statsBuf, sizeof(statsBuf), "%sCombo %d  Acc %.1f%%", levelBuf, stats.combo, stats.accuracy);
+    int scale = 2;
+    int statsW = (int)std::strlen(statsBuf) * 8 * scale;
+    drawText(rs.r, statsBuf, rs.w - statsW - 10, 10, scale, SDL_Color{200,200,220,255});
+  }
 
   // Fret number hints along bottom
-  int fretScale = 1;
-  int baseY = rs.h - 12 * fretScale - 4;
-  int spacing = rs.w / (kMaxFrets + 1);
-  for (int i = 0; i <= kMaxFrets; ++i) {
-    char buf[4];
-    snprintf(buf, sizeof(buf), "%d", i);
-    int x = i * spacing + 5;
-    drawText(rs.r, buf, x, baseY, fretScale, SDL_Color{120,120,140,255});
+  SDL_Rect hint = fretHintRect(rs);
+  if (rs.fretHintTex) {
+    SDL_RenderCopy(rs.r, rs.fretHintTex, nullptr, &hint);
+  } else {
+    drawFretHintLayer(rs, hint.y);
   }
 
   if (app.showFrameGraph) renderFrameGraph(app);
 
-  SDL_RenderPresent(rs.r);
+  presentFrame(rs);
 }
 
 // --------- Render helpers for other states ---------
@@ -624,6 +1218,7 @@ static const std::vector<std::pair<const char*, AppState>> kMenu = {
   {"Tuner", AppState::Tuner},
   {"Free Play", AppState::FreePlay},
   {"Settings", AppState::Settings},
+  {"Calibrate", AppState::Calibrate},
   {"Play", AppState::Play},
 };
 
@@ -647,7 +1242,7 @@ void renderTitle(App& app) {
     drawTextCentered(app.rs, kMenu[i].first, textY, scale, SDL_Color{20,20,20,255});
   }
   if (app.showFrameGraph) renderFrameGraph(app);
-  SDL_RenderPresent(app.rs.r);
+  presentFrame(app.rs);
 }
 
 void updateTitle(App& app, const SDL_Event& e) {
@@ -660,7 +1255,6 @@ void updateTitle(App& app, const SDL_Event& e) {
       app.menuIndex = (app.menuIndex + 1) % (int)kMenu.size();
     } else if (e.key.keysym.sym == SDLK_RETURN) {
       app.state = kMenu[app.menuIndex].second;
-      app.t0 = std::chrono::steady_clock::now();
     } else if (e.key.keysym.sym == SDLK_ESCAPE) {
       app.running = false;
     }
@@ -678,7 +1272,6 @@ void updateTitle(App& app, const SDL_Event& e) {
         my >= startY && my < startY + (int)kMenu.size()*itemH) {
       app.menuIndex = (my - startY) / itemH;
       app.state = kMenu[app.menuIndex].second;
-      app.t0 = std::chrono::steady_clock::now();
     }
   }
 }
@@ -687,7 +1280,7 @@ void renderStub(App& app) {
   SDL_SetRenderDrawColor(app.rs.r, 20,20,25,255);
   SDL_RenderClear(app.rs.r);
   if (app.showFrameGraph) renderFrameGraph(app);
-  SDL_RenderPresent(app.rs.r);
+  presentFrame(app.rs);
 }
 
 void updateReturnToTitle(App& app, const SDL_Event& e) {
@@ -732,7 +1325,7 @@ void renderTuner(App& app) {
       SDL_RenderDrawLine(app.rs.r, px, cy-60, px, cy+60);
 
       // string name
-      const char* sname = (dn.stringIdx >=0 && dn.stringIdx < 6) ? g_stringNames[dn.stringIdx].c_str() : "--";
+      const char* sname = (dn.stringIdx >=0 && dn.stringIdx < kMaxStrings) ? g_stringNames[dn.stringIdx].c_str() : "--";
       drawTextCentered(app.rs, sname, cy-120, 8, SDL_Color{200,200,220,255});
 
       // Hz value
@@ -742,22 +1335,261 @@ void renderTuner(App& app) {
     }
   }
   if (app.showFrameGraph) renderFrameGraph(app);
-  SDL_RenderPresent(app.rs.r);
+  presentFrame(app.rs);
 }
 
 void updateTuner(App& app, const SDL_Event& e){ updateReturnToTitle(app,e); }
 
-void renderPlay(App& app, int64_t now_ms){
-  updateGameplay(app, now_ms);
-  drawChart(app, app.chart.notes.empty()?nullptr:&app.chart, now_ms);
+// --------- Latency calibration screen ---------
+// Drive the audio callback from the calibrator and collect its onsets. Leaving
+// the screen abandons a running calibration.
+void syncCalibration(App& app) {
+  Calibrator& c = app.calib;
+  if (app.state != AppState::Calibrate && c.phase != Calibrator::Phase::Idle && c.phase != Calibrator::Phase::Done)
+    c.phase = Calibrator::Phase::Idle;
+  int64_t now = app.clock->nowUs();
+  int64_t us;
+  while (g_calibration.onsets.pop(us)) c.addOnset(us);
+  if (c.update(now)) app.redraw = true;
+  bool clicking = c.clicking();
+  if (clicking && !g_calibration.clicking.load(std::memory_order_relaxed)) {
+    g_calibration.startUs.store(c.sched.startUs, std::memory_order_relaxed);
+    g_calibration.periodUs.store(c.sched.periodUs, std::memory_order_relaxed);
+    g_calibration.count.store(c.sched.count, std::memory_order_relaxed);
+  }
+  g_calibration.clicking.store(clicking, std::memory_order_release);
+  g_calibration.listening.store(c.phase == Calibrator::Phase::Audio || c.phase == Calibrator::Phase::Visual,
+                                std::memory_order_relaxed);
+}
+
+void renderCalibrate(App& app) {
+  const Calibrator& c = app.calib;
+  int64_t now = app.clock->nowUs();
+  bool flash = c.flashing(now);
+  if (flash) SDL_SetRenderDrawColor(app.rs.r, 230,230,240,255);
+  else SDL_SetRenderDrawColor(app.rs.r, 12,12,16,255);
+  SDL_RenderClear(app.rs.r);
+  SDL_Color text = flash ? SDL_Color{20,20,20,255} : SDL_Color{200,200,220,255};
+  int cy = app.rs.h/2;
+  char buf[64];
+  drawTextCentered(app.rs, "Latency calibration", cy-160, 4, text);
+  switch (c.phase) {
+    case Calibrator::Phase::Idle:
+      std::snprintf(buf, sizeof(buf), "audio %d ms  visual %d ms",
+                    app.settings.audioOffsetMs, app.settings.visualOffsetMs);
+      drawTextCentered(app.rs, buf, cy-60, 2, text);
+      drawTextCentered(app.rs, "ENTER: start   L: loopback", cy, 2, text);
+      drawTextCentered(app.rs, c.loopback ? "loopback: on (patch output to input)" : "loopback: off",
+                       cy+40, 2, text);
+      break;
+    case Calibrator::Phase::Audio:
+    case Calibrator::Phase::Visual:
+      drawTextCentered(app.rs, c.phase == Calibrator::Phase::Audio
+                         ? (c.loopback ? "Listening to the loopback" : "Pluck a muted string on each click")
+                         : "Pluck a muted string on each flash", cy-60, 2, text);
+      std::snprintf(buf, sizeof(buf), "%d", c.beatsLeft(now));
+      drawTextCentered(app.rs, buf, cy, 6, text);
+      break;
+    case Calibrator::Phase::Done:
+      if (c.ok()) {
+        std::snprintf(buf, sizeof(buf), "audio %d ms (+-%.0f)", c.audioOffsetMs(), c.audio.jitterMs);
+        drawTextCentered(app.rs, buf, cy-60, 3, text);
+        if (!c.loopback) {
+          std::snprintf(buf, sizeof(buf), "visual %d ms (+-%.0f)", c.visualOffsetMs(), c.visual.jitterMs);
+          drawTextCentered(app.rs, buf, cy-20, 3, text);
+        }
+        drawTextCentered(app.rs, "ENTER: save   ESC: discard", cy+40, 2, text);
+      } else {
+        drawTextCentered(app.rs, "Not enough plucks heard", cy-60, 3, text);
+        drawTextCentered(app.rs, "ENTER: try again   ESC: back", cy+40, 2, text);
+      }
+      break;
+  }
+  if (app.showFrameGraph) renderFrameGraph(app);
+  presentFrame(app.rs);
+}
+
+void updateCalibrate(App& app, const SDL_Event& e) {
+  if (e.type != SDL_KEYDOWN) return;
+  Calibrator& c = app.calib;
+  SDL_Keycode k = e.key.keysym.sym;
+  if (k == SDLK_ESCAPE) {
+    c.phase = Calibrator::Phase::Idle;
+    app.state = AppState::Title;
+  } else if (k == SDLK_l && c.phase == Calibrator::Phase::Idle) {
+    c.loopback = !c.loopback;
+  } else if (k == SDLK_RETURN) {
+    if (c.phase == Calibrator::Phase::Done && c.ok()) {
+      app.settings.audioOffsetMs = c.audioOffsetMs();
+      if (!c.loopback) app.settings.visualOffsetMs = c.visualOffsetMs();
+      g_audioOffsetMs.store(app.settings.audioOffsetMs);
+      g_visualOffsetMs.store(app.settings.visualOffsetMs);
+      c.phase = Calibrator::Phase::Idle;
+    } else if (c.phase == Calibrator::Phase::Idle || c.phase == Calibrator::Phase::Done) {
+      c.begin(app.clock->nowUs(), c.loopback);
+    }
+  }
+}
+
+// Song time to draw at: the latest simulation snapshot carried forward to
+// the current clock time (the sim ticks far faster than we draw).
+int64_t renderSongMs(const PlaySnapshot& snap, const Clock& clock) {
+  int64_t ms = snap.songMs;
+  if (snap.playing) ms += (int64_t)(std::max<int64_t>(0, clock.nowUs() - snap.clockUs) * snap.rate) / 1000;
+  return ms;
+}
+
+void renderPlay(App& app){
+  PlaySnapshot snap = app.sim.snapshot();
+  app.stats = snap.stats;
+  int64_t songMs = renderSongMs(snap, *app.clock) +
+                   std::llround(g_visualOffsetMs.load(std::memory_order_relaxed) * snap.rate);
+  drawChart(app, app.chart.notes.empty()?nullptr:&app.chart, songMs);
+}
+
+// Start the simulation when Play is entered and stop it when it is left.
+void syncSimulation(App& app) {
+  bool want = app.state == AppState::Play;
+  if (want == app.sim.running.load()) return;
+  if (want) {
+    app.stats = GameplayStats{};
+    app.stats.level = app.settings.difficulty;
+    app.sim.level.store(app.settings.difficulty);
+    app.sim.adaptive.store(app.settings.adaptiveDifficulty);
+    app.sim.track = app.track.isOpen() ? &app.track : nullptr;
+    app.track.restart();
+    app.track.playing.store(app.playing);
+    app.track.setRate(app.playbackRate);
+    app.sim.rate.store(app.playbackRate);
+    app.sim.recorder = nullptr;
+    if (app.sim.replay) app.sim.replay->rewind();
+    else if (app.settings.recordSessions) {
+      std::error_code ec;
+      fs::create_directories("sessions", ec);
+      char name[64];
+      std::time_t now = std::time(nullptr);
+      std::strftime(name, sizeof(name), "sessions/%Y%m%d-%H%M%S.rtlog", std::localtime(&now));
+      if (app.recorder.open(name, chartHash(app.chart), app.chart.title)) app.sim.recorder = &app.recorder;
+      else std::cerr << "Can't record session to " << name << "\n";
+    }
+    app.sim.start(app.chart, app.playing, *app.clock);
+    app.metronome.chart.store(app.settings.metronome ? &app.chart : nullptr);
+  } else {
+    app.metronome.chart.store(nullptr);
+    app.sim.stop();
+    app.track.playing.store(false);
+    if (app.recorder.isOpen()) {
+      GameplayStats s = app.sim.snapshot().stats;
+      app.recorder.close((uint64_t)s.hits, (uint64_t)s.misses);
+      if (uint64_t lost = app.recorder.lostBytes.load())
+        std::cerr << "Session log dropped " << lost << " bytes\n";
+    }
+  }
 }
 
 void updatePlay(App& app, const SDL_Event& e){
   if (e.type != SDL_KEYDOWN) return;
   if (e.key.keysym.sym == SDLK_ESCAPE) app.state = AppState::Title;
-  if (e.key.keysym.sym == SDLK_SPACE) app.playing = !app.playing;
+  if (e.key.keysym.sym == SDLK_SPACE) {
+    app.playing = !app.playing;
+    app.sim.playing.store(app.playing, std::memory_order_relaxed);
+    app.track.playing.store(app.playing, std::memory_order_relaxed);
+  }
   if (e.key.keysym.sym == SDLK_EQUALS || e.key.keysym.sym == SDLK_PLUS) g_latencyOffsetMs.fetch_add(5);
   if (e.key.keysym.sym == SDLK_MINUS) g_latencyOffsetMs.fetch_add(-5);
+  if (e.key.keysym.sym == SDLK_LEFTBRACKET || e.key.keysym.sym == SDLK_RIGHTBRACKET) {
+    double step = e.key.keysym.sym == SDLK_LEFTBRACKET ? -0.05 : 0.05;
+    app.playbackRate = std::clamp(std::round((app.playbackRate + step) * 20.0) / 20.0,
+                                  BackingTrack::kMinRate, BackingTrack::kMaxRate);
+    app.track.setRate(app.playbackRate);
+    app.sim.rate.store(app.playbackRate, std::memory_order_relaxed);
+  }
+  if (e.key.keysym.sym == SDLK_m) {
+    app.settings.metronome = !app.settings.metronome;
+    app.metronome.chart.store(app.settings.metronome ? &app.chart : nullptr);
+  }
+  // Difficulty takes effect on the next simulation tick, from the next note.
+  // It steps from the level being judged, which adaptive mode may have moved.
+  if (e.key.keysym.sym == SDLK_PAGEUP || e.key.keysym.sym == SDLK_PAGEDOWN) {
+    int step = e.key.keysym.sym == SDLK_PAGEDOWN ? -1 : 1;
+    app.settings.difficulty = std::clamp(app.stats.level + step, 0, kDifficultyLevels - 1);
+    app.sim.level.store(app.settings.difficulty, std::memory_order_relaxed);
+  }
+  if (e.key.keysym.sym == SDLK_a) {
+    app.settings.adaptiveDifficulty = !app.settings.adaptiveDifficulty;
+    app.sim.adaptive.store(app.settings.adaptiveDifficulty, std::memory_order_relaxed);
+  }
+  // Highway speed and look-ahead; drawChart picks them up on the next frame.
+  if (e.key.keysym.sym == SDLK_UP || e.key.keysym.sym == SDLK_DOWN) {
+    double step = e.key.keysym.sym == SDLK_DOWN ? -0.1 : 0.1;
+    app.settings.scrollSpeed = std::clamp(std::round((app.settings.scrollSpeed + step) * 10.0) / 10.0,
+                                          HighwayView::kMinSpeed, HighwayView::kMaxSpeed);
+  }
+  if (e.key.keysym.sym == SDLK_LEFT || e.key.keysym.sym == SDLK_RIGHT) {
+    int step = e.key.keysym.sym == SDLK_LEFT ? -250 : 250;
+    app.settings.lookAheadMs = std::clamp(app.settings.lookAheadMs + step,
+                                          HighwayView::kMinLookAheadMs, HighwayView::kMaxLookAheadMs);
+  }
+}
+
+// --------- Event dispatch + damage tracking ---------
+void handleEvent(App& app, const SDL_Event& e) {
+  if (e.type == SDL_QUIT) app.running = false;
+  else if (e.type == SDL_RENDER_TARGETS_RESET) {
+    // Some backends (D3D) drop target contents: rebuild the cached layers.
+    app.rs.layersValid = false;
+    app.redraw = true;
+  } else if (e.type == SDL_RENDER_DEVICE_RESET) {
+    // Every texture is gone; start over.
+    destroyRenderTargets(app.rs);
+    createRenderTargets(app.rs);
+    app.redraw = true;
+  }
+  else if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_F3) {
+    // The overlay's phase bars need the profiler, so they toggle together.
+    app.showFrameGraph = !app.showFrameGraph;
+    Profiler::instance().enabled.store(app.showFrameGraph);
+  } else if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_F4) {
+    // Dump whatever the rings hold (the last few seconds while F3 is on).
+    const char* path = "rocktrainer_trace.json";
+    if (Profiler::instance().writeChromeTrace(path))
+      std::cout << "Wrote profiler trace to " << path << "\n";
+  } else {
+    switch (app.state) {
+      case AppState::Title:   updateTitle(app, e); break;
+      case AppState::Library: updateLibrary(app, e); break;
+      case AppState::Tuner:   updateTuner(app, e); break;
+      case AppState::FreePlay:updateFreePlay(app, e); break;
+      case AppState::Settings:updateSettings(app, e); break;
+      case AppState::Calibrate:updateCalibrate(app, e); break;
+      case AppState::Play:    updatePlay(app, e); break;
+    }
+  }
+  // Any input or window event may change what the menus show.
+  app.redraw = true;
+}
+
+// Play, a running calibration and the frame graph animate every frame;
+// everything else renders on demand. The tuner is invalidated by the
+// detector publishing a new pitch.
+bool needsRedraw(App& app) {
+  if (app.state == AppState::Play || app.showFrameGraph) return true;
+  if (app.state == AppState::Calibrate && app.calib.phase != Calibrator::Phase::Idle &&
+      app.calib.phase != Calibrator::Phase::Done) return true;
+  if (app.state == AppState::Tuner) {
+    float hz = g_detectedHz.load(std::memory_order_relaxed);
+    if (hz != app.drawnHz) {
+      app.drawnHz = hz;
+      app.redraw = true;
+    }
+  }
+  return app.redraw;
+}
+
+// How long an idle screen may block in SDL_WaitEventTimeout. The tuner polls
+// the detector at display rate; static menus only wake for events.
+int idleWaitMs(const App& app) {
+  return app.state == AppState::Tuner || app.state == AppState::Calibrate ? 16 : 250;
 }
 
 // --------- Main ---------
@@ -774,7 +1606,21 @@ int main(int argc, char** argv) {
     dataRoot = exeDir.parent_path();
   }
 
-  fs::path chartPath = (argc > 1) ? fs::path(argv[1]) : fs::path("charts") / "example.json";
+  fs::path chartPath = fs::path("charts") / "example.json";
+  std::string frameCsvPath;
+  std::string trackPath;
+  std::string replayPath;
+  double replaySpeed = 1.0;
+  bool printStats = false;
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg = argv[i];
+    if (arg == "--frame-csv" && i + 1 < argc) frameCsvPath = argv[++i];
+    else if (arg == "--stats") printStats = true;
+    else if (arg == "--track" && i + 1 < argc) trackPath = argv[++i];
+    else if (arg == "--replay" && i + 1 < argc) replayPath = argv[++i];
+    else if (arg == "--replay-speed" && i + 1 < argc) replaySpeed = std::max(0.0, std::atof(argv[++i]));
+    else chartPath = fs::path(argv[i]);
+  }
   if (!chartPath.is_absolute()) {
     chartPath = dataRoot / chartPath;
   }
@@ -792,44 +1638,108 @@ int main(int argc, char** argv) {
   App app{};
   loadConfig("config.json", app.settings);
   g_latencyOffsetMs.store(app.settings.latencyOffset);
+  g_audioOffsetMs.store(app.settings.audioOffsetMs);
+  g_visualOffsetMs.store(app.settings.visualOffsetMs);
   app.chart = loadChart(chartPath).value_or(Chart{});
-  g_stringOpenMidi = app.chart.tuning;
-  for (int i=0;i<6;++i) {
-    auto [n, oct] = midiToName(g_stringOpenMidi[i]);
-    g_stringNames[i] = n + std::to_string(oct);
+  setInstrument(app.chart);
+
+  // A replay takes every input from the log: no audio, and the session's own
+  // latency settings rather than config.json's.
+  SessionReplay replay;
+  std::optional<ScaledClock> replayClock;
+  auto replayReport = [&](const GameplayStats& s) {
+    std::printf("replay: %llu ticks, %d hits, %d misses (recorded %llu hits, %llu misses)\n",
+                (unsigned long long)replay.ticks, s.hits, s.misses,
+                (unsigned long long)replay.hits, (unsigned long long)replay.misses);
+    return (uint64_t)s.hits == replay.hits && (uint64_t)s.misses == replay.misses ? 0 : 2;
+  };
+  if (!replayPath.empty()) {
+    if (!replay.load(replayPath)) {
+      std::cerr << "Not a valid session log: " << replayPath << "\n";
+      return 1;
+    }
+    if (replay.hash != chartHash(app.chart)) {
+      std::cerr << "Session log " << replayPath << " was recorded on another chart (\"" << replay.title << "\")\n";
+      return 1;
+    }
+    // Speed 0: judge it headless, as fast as possible.
+    if (replaySpeed <= 0.0) return replayReport(replaySession(app.chart, replay));
+    app.sim.replay = &replay;
+    app.clock = &replayClock.emplace(app.steadyClock, replaySpeed);
+    app.state = AppState::Play;
   }
 #ifdef RT_ENABLE_AUDIO
   AudioState st{};
   PaStream* stream = nullptr;
 
-  Pa_Initialize();
-  app.settings.audioDevices = listAudioDevices();
-  int dev = app.settings.audioDeviceIndex;
-  if (dev < 0) dev = Pa_GetDefaultInputDevice();
-  const PaDeviceInfo* info = Pa_GetDeviceInfo(dev);
-  if (!info) {
-    std::cerr << "No input device found.\n";
-    return 1;
+  if (!app.sim.replay) {
+    Pa_Initialize();
+    app.settings.audioDevices = listAudioDevices();
+    int dev = app.settings.audioDeviceIndex;
+    if (dev < 0) dev = Pa_GetDefaultInputDevice();
+    const PaDeviceInfo* info = Pa_GetDeviceInfo(dev);
+    if (!info) {
+      std::cerr << "No input device found.\n";
+      return 1;
+    }
+    app.settings.audioDeviceIndex = dev;
+    std::cout << "Using input: " << info->name << "\n";
+
+    PaStreamParameters in{};
+    in.device = dev;
+    in.channelCount = 1;
+    in.sampleFormat = paFloat32;
+    in.suggestedLatency = info ? info->defaultLowInputLatency : 0.0;
+    in.hostApiSpecificStreamInfo = nullptr;
+
+    st.hop = app.settings.bufferSize;
+    st.inputFrame = new_fvec(st.hop);
+    st.pitchOut = new_fvec(1);
+    st.clock = &app.audioClock;
+    st.pitch = new_aubio_pitch("yinfast", kWinSize, st.hop, (unsigned)kSampleRate);
+    aubio_pitch_set_unit(st.pitch, "Hz");
+    aubio_pitch_set_silence(st.pitch, kSilenceDb);
+
+    // Duplex when there is an output device (calibration clicks), falling back
+    // to input only.
+    PaStreamParameters out{};
+    out.device = Pa_GetDefaultOutputDevice();
+    const PaDeviceInfo* outInfo = out.device != paNoDevice ? Pa_GetDeviceInfo(out.device) : nullptr;
+    PaError err = paInvalidDevice;
+    if (outInfo && outInfo->maxOutputChannels > 0) {
+      out.channelCount = std::min(2, outInfo->maxOutputChannels);
+      out.sampleFormat = paFloat32;
+      out.suggestedLatency = outInfo->defaultLowOutputLatency;
+      st.outChannels = out.channelCount;
+      err = Pa_OpenStream(&stream, &in, &out, kSampleRate, st.hop, paNoFlag, audioCb, &st);
+    }
+    if (err != paNoError) {
+      st.outChannels = 0;
+      err = Pa_OpenStream(&stream, &in, nullptr, kSampleRate, st.hop, paNoFlag, audioCb, &st);
+    }
+    if (err != paNoError) { std::cerr << "Pa_OpenStream: " << Pa_GetErrorText(err) << "\n"; return 1; }
+    g_audioStats.sampleRate = kSampleRate;
+    g_audioStats.requestedLatencyMs = in.suggestedLatency * 1000.0;
+    if (const PaStreamInfo* si = Pa_GetStreamInfo(stream)) {
+      g_audioStats.sampleRate = si->sampleRate;
+      g_audioStats.inputLatencyMs = si->inputLatency * 1000.0;
+      g_audioStats.outputLatencyMs = si->outputLatency * 1000.0;
+    }
+    st.click = makeClick(g_audioStats.sampleRate);
+    if (st.outChannels > 0) {
+      app.metronome.prepare(g_audioStats.sampleRate);
+      st.metronome = &app.metronome;
+      st.song = &app.sim.song;
+    }
+    if (trackPath.empty()) trackPath = app.chart.audio;
+    if (!trackPath.empty()) {
+      if (st.outChannels == 0) std::cerr << "No output device; backing track disabled.\n";
+      else if (!app.track.open(trackPath, g_audioStats.sampleRate)) std::cerr << "Can't play backing track: " << trackPath << "\n";
+      else st.track = &app.track;
+    }
+    st.profileRing = Profiler::instance().addRing("audio");
+    Pa_StartStream(stream);
   }
-  app.settings.audioDeviceIndex = dev;
-  std::cout << "Using input: " << info->name << "\n";
-
-  PaStreamParameters in{};
-  in.device = dev;
-  in.channelCount = 1;
-  in.sampleFormat = paFloat32;
-  in.suggestedLatency = info ? info->defaultLowInputLatency : 0.0;
-  in.hostApiSpecificStreamInfo = nullptr;
-
-  st.hop = app.settings.bufferSize;
-  st.inputFrame = new_fvec(st.hop);
-  st.pitch = new_aubio_pitch("yinfast", kWinSize, st.hop, (unsigned)kSampleRate);
-  aubio_pitch_set_unit(st.pitch, "Hz");
-  aubio_pitch_set_silence(st.pitch, kSilenceDb);
-
-  PaError err = Pa_OpenStream(&stream, &in, nullptr, kSampleRate, st.hop, paNoFlag, audioCb, &st);
-  if (err != paNoError) { std::cerr << "Pa_OpenStream: " << Pa_GetErrorText(err) << "\n"; return 1; }
-  Pa_StartStream(stream);
 #else
   app.settings.audioDevices.clear();
 #endif
@@ -839,66 +1749,93 @@ int main(int argc, char** argv) {
   // Init SDL
   if (!initSDL(app.rs, app.settings)) { std::cerr << "SDL init failed\n"; return 1; }
 
+  SDL_DisplayMode mode{};
+  int displayHz = 0;
+  if (SDL_GetCurrentDisplayMode(SDL_GetWindowDisplayIndex(app.rs.window), &mode) == 0)
+    displayHz = mode.refresh_rate;
+  FramePacer pacer;
+  pacer.configure(app.settings.targetFps, app.settings.vsync, displayHz);
+  int expectedHz = app.settings.targetFps > 0 ? app.settings.targetFps : displayHz;
+  if (app.settings.vsync && displayHz > 0 && (expectedHz <= 0 || expectedHz > displayHz))
+    expectedHz = displayHz;
+  app.frameStats.targetMs = 1000.0 / (expectedHz > 0 ? expectedHz : 60);
+  app.frameStats.keepSamples = !frameCsvPath.empty();
+
   const double freq = (double)SDL_GetPerformanceFrequency();
   Uint64 lastCounter = SDL_GetPerformanceCounter();
 
+  Profiler::instance().setThreadName("main");
+
   // Main loop
+  int exitCode = 0;
   while (app.running) {
+    pacer.beginFrame();
+    SDL_Event e;
+    if (!needsRedraw(app)) {
+      // Nothing on screen is changing: block until an event arrives or the
+      // tuner needs to look at the detector again.
+      if (SDL_WaitEventTimeout(&e, idleWaitMs(app))) handleEvent(app, e);
+      lastCounter = SDL_GetPerformanceCounter(); // idle time isn't frame time
+    }
+    {
+      RT_PROFILE_SCOPE("frame.events");
+      while (SDL_PollEvent(&e)) handleEvent(app, e);
+    }
+    syncSimulation(app);
+    syncCalibration(app);
+    if (app.sim.replay && app.sim.replayDone.load()) {
+      exitCode = replayReport(app.sim.snapshot().stats);
+      break;
+    }
+    if (!needsRedraw(app)) continue;
+    app.redraw = false;
+
     Uint64 nowCounter = SDL_GetPerformanceCounter();
     float dt_ms = float((nowCounter - lastCounter) * 1000.0 / freq);
     lastCounter = nowCounter;
     app.frameTimes[app.frameTimeIdx] = dt_ms;
     app.frameTimeIdx = (app.frameTimeIdx + 1) % kFrameHistory;
     if (app.frameTimeIdx == 0) app.frameTimesFull = true;
+    app.frameStats.record(dt_ms);
 
-    SDL_Event e;
-    while (SDL_PollEvent(&e)) {
-      if (e.type == SDL_QUIT) app.running = false;
-      else if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_F3) {
-        app.showFrameGraph = !app.showFrameGraph;
-      } else {
-        switch (app.state) {
-          case AppState::Title:   updateTitle(app, e); break;
-          case AppState::Library: updateLibrary(app, e); break;
-          case AppState::Tuner:   updateTuner(app, e); break;
-          case AppState::FreePlay:updateFreePlay(app, e); break;
-          case AppState::Settings:updateSettings(app, e); break;
-          case AppState::Play:    updatePlay(app, e); break;
-        }
-      }
-    }
-
-    int64_t now_ms = 0;
-    if (app.state == AppState::Play) {
-      now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-        std::chrono::steady_clock::now() - app.t0).count();
-      if (!app.playing) { app.t0 = std::chrono::steady_clock::now(); }
-      now_ms += g_latencyOffsetMs.load();
-    }
+    uint64_t frameNs = Profiler::nowNs();
+    if (app.showFrameGraph)
+      Profiler::instance().summarize(app.frameStartNs, frameNs, app.phaseTimes);
+    app.frameStartNs = frameNs;
 
+    RT_PROFILE_SCOPE("frame");
     switch (app.state) {
       case AppState::Title:   renderTitle(app); break;
       case AppState::Library: renderLibrary(app); break;
       case AppState::Tuner:   renderTuner(app); break;
       case AppState::FreePlay:renderFreePlay(app); break;
       case AppState::Settings:renderSettings(app); break;
-      case AppState::Play:    renderPlay(app, now_ms); break;
+      case AppState::Calibrate:renderCalibrate(app); break;
+      case AppState::Play:    renderPlay(app); break;
     }
 
-    SDL_Delay(16); // ~60fps
+    RT_PROFILE_SCOPE("frame.pace");
+    pacer.wait();
   }
 
   // Cleanup
+  app.state = AppState::Title;
+  syncSimulation(app); // closes the session log
 #ifdef RT_ENABLE_AUDIO
-  if (stream) { Pa_StopStream(stream); Pa_CloseStream(stream); }
-  del_aubio_pitch(st.pitch);
-  del_fvec(st.inputFrame);
-  Pa_Terminate();
+  // The track's report outlives it.
+  bool hadTrack = app.track.isOpen();
+  double trackSec = app.track.durationSec();
+  if (!app.sim.replay) {
+    if (stream) { Pa_StopStream(stream); Pa_CloseStream(stream); }
+    app.track.close();
+    del_aubio_pitch(st.pitch);
+    del_fvec(st.inputFrame);
+    del_fvec(st.pitchOut);
+    Pa_Terminate();
+  }
 #endif
 
-  if (app.rs.blurTex) SDL_DestroyTexture(app.rs.blurTex);
-  if (app.rs.bloomTex) SDL_DestroyTexture(app.rs.bloomTex);
-  if (app.rs.laneTex) SDL_DestroyTexture(app.rs.laneTex);
+  destroyRenderTargets(app.rs);
   if (app.rs.r) SDL_DestroyRenderer(app.rs.r);
   if (app.rs.window) SDL_DestroyWindow(app.rs.window);
   SDL_Quit();
@@ -906,6 +1843,23 @@ int main(int argc, char** argv) {
   app.settings.latencyOffset = g_latencyOffsetMs.load();
   saveConfig("config.json", app.settings);
 
-  return 0;
+  if (!frameCsvPath.empty() && !app.frameStats.writeCsv(frameCsvPath))
+    std::cerr << "Could not write frame times to " << frameCsvPath << "\n";
+  if (printStats) {
+    const FrameStats& fst = app.frameStats;
+    std::printf("frames: %llu, mean %.2f ms, p50 %.2f, p95 %.2f, p99 %.2f, max %.2f ms, %llu dropped\n",
+                (unsigned long long)fst.total, fst.meanMs(), fst.percentile(50), fst.percentile(95),
+                fst.percentile(99), fst.maxMs(), (unsigned long long)fst.dropped);
+#ifdef RT_ENABLE_AUDIO
+    g_audioStats.printReport(stdout);
+    if (hadTrack)
+      std::printf("audio: backing track %.1f s, %llu ring underruns\n", trackSec,
+                  (unsigned long long)app.track.underruns.load());
+#else
+    std::printf("audio: built without audio support\n");
+#endif
+  }
+
+  return exitCode;
 }
 #endif // ROCKTRAINER_NO_MAIN
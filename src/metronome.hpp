@@ -0,0 +1,46 @@
+#pragma once
+#include "calibration.hpp"
+#include "tempo_map.hpp"
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+// Click track for Play. The audio callback knows the song time its buffer's
+// first frame will be heard at and how fast the song runs, so every beat of
+// the chart's tempo map is placed at its exact sample offset in the output
+// (and lands on the beat whatever the buffer size). Clicks are rendered once
+// per sample rate and only added in the callback; a click that straddles a
+// buffer boundary is finished from the next buffer's (negative) offset. The
+// clicks keep their pitch and length when the song is slowed down.
+struct Metronome {
+  std::vector<float> accent; // first beat of a bar
+  std::vector<float> beat;
+  std::atomic<const Chart*> chart{nullptr}; // clicked while set, by the UI
+
+  void prepare(double sampleRate) {
+    accent = makeClick(sampleRate, 2000.0, 20.0, 0.5f);
+    beat = makeClick(sampleRate, 1200.0, 15.0, 0.35f);
+  }
+
+  // Add the clicks heard in a buffer of `frames` frames (interleaved,
+  // `channels` wide) whose first frame plays song time songUs, with the song
+  // advancing `rate` us per real us. Nothing plays while the rate is 0.
+  void mix(float* out, std::size_t frames, int channels, double sampleRate, const TempoMap& map,
+           int64_t songUs, double rate) const {
+    if (rate <= 0.0 || accent.empty()) return;
+    double framesPerSongUs = sampleRate / 1e6 / rate;
+    int64_t endUs = songUs + (int64_t)std::ceil((double)frames / framesPerSongUs);
+    int64_t tailUs = (int64_t)std::ceil((double)accent.size() / framesPerSongUs);
+    map.forEachBeat(songUs - tailUs, endUs, [&](int64_t t, bool downbeat) {
+      const std::vector<float>& click = downbeat ? accent : beat;
+      // Frame offset of the beat relative to the buffer start (may be negative).
+      int64_t off = (int64_t)std::llround((double)(t - songUs) * framesPerSongUs);
+      int64_t from = std::max<int64_t>(0, off);
+      int64_t to = std::min<int64_t>((int64_t)frames, off + (int64_t)click.size());
+      for (int64_t i = from; i < to; ++i) {
+        float s = click[(std::size_t)(i - off)];
+        for (int c = 0; c < channels; ++c) out[i * channels + c] += s;
+      }
+    });
+  }
+};
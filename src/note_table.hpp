@@ -0,0 +1,100 @@
+#pragma once
+#include "instrument.hpp"
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+
+// Pitch classification without transcendental calls.
+//
+// fastLog2() splits a double into exponent and mantissa and reads log2 of
+// the mantissa from a 256-step table with linear interpolation (error below
+// 3e-6, i.e. 0.004 cents). A NoteTable, built once per tuning, holds every
+// MIDI note's candidate (string, fret) positions, so classifying a detected
+// frequency is one log2 lookup, a rounding, and a table read. Tables are
+// specialized per instrument profile (string count and fret range).
+
+// log2(1 + i / 256) for i in [0, 256].
+inline const std::array<double, 257> kLog2Mantissa = [] {
+  std::array<double, 257> t{};
+  for (int i = 0; i <= 256; ++i) t[i] = std::log2(1.0 + i / 256.0);
+  return t;
+}();
+
+// log2(x) for positive, normal x.
+inline double fastLog2(double x) {
+  uint64_t bits;
+  std::memcpy(&bits, &x, sizeof(bits));
+  int e = (int)((bits >> 52) & 0x7FF) - 1023;
+  uint64_t mant = bits & ((uint64_t(1) << 52) - 1);
+  int i = (int)(mant >> 44);                                     // top 8 mantissa bits
+  double frac = (double)(mant & ((uint64_t(1) << 44) - 1)) * 0x1p-44; // position within the step
+  return e + kLog2Mantissa[i] + (kLog2Mantissa[i + 1] - kLog2Mantissa[i]) * frac;
+}
+
+// MIDI number of 1 Hz: midi = kMidiAt1Hz + 12 * log2(hz).
+inline const double kMidiAt1Hz = 69.0 - 12.0 * std::log2(440.0);
+
+struct DetectedNote {
+  int midi;          // nearest midi
+  double cents;      // deviation from nearest
+  int stringIdx;     // 0..strings-1 (lowest..highest) best match
+  int fret;          // 0..frets if in range, else -1
+};
+
+struct NotePosition {
+  int8_t stringIdx;
+  int8_t fret;
+};
+
+template <class InstrumentT>
+struct BasicNoteTable {
+  using Profile = InstrumentT;
+  using Position = NotePosition;
+  static constexpr int kStrings = Profile::kStrings;
+
+  // Where a note can be played, lowest string (highest fret) first.
+  struct Entry {
+    uint8_t count = 0;
+    std::array<Position, kStrings> pos{};
+  };
+
+  std::array<int, kStrings> tuning{};  // open-string MIDI numbers, low to high
+  std::array<Entry, 128> notes{};
+
+  BasicNoteTable() : BasicNoteTable(Profile::standardTuning().data()) {}
+  explicit BasicNoteTable(const int* openMidi) { build(openMidi); }
+
+  // openMidi: kStrings open-string MIDI numbers, lowest first.
+  void build(const int* openMidi) {
+    for (int s = 0; s < kStrings; ++s) tuning[s] = openMidi[s];
+    for (int m = 0; m < 128; ++m) {
+      Entry& e = notes[m];
+      e.count = 0;
+      for (int s = 0; s < kStrings; ++s) {
+        int fret = m - tuning[s];
+        if (fret >= 0 && fret <= Profile::kFrets) e.pos[e.count++] = Position{(int8_t)s, (int8_t)fret};
+      }
+    }
+  }
+
+  const Entry* candidates(int midi) const { return midi >= 0 && midi < 128 ? &notes[midi] : nullptr; }
+
+  // Nearest note to hz, its deviation in cents, and the default position:
+  // the lowest string that can play it (-1/-1 if none can).
+  std::optional<DetectedNote> classify(double hz) const {
+    if (!(hz > 0.0)) return std::nullopt;
+    double midiF = kMidiAt1Hz + 12.0 * fastLog2(hz);
+    int midi = (int)std::floor(midiF + 0.5);
+    DetectedNote d{midi, 100.0 * (midiF - midi), -1, -1};
+    const Entry* e = candidates(midi);
+    if (e && e->count > 0) {
+      d.stringIdx = e->pos[0].stringIdx;
+      d.fret = e->pos[0].fret;
+    }
+    return d;
+  }
+};
+
+using NoteTable = BasicNoteTable<Guitar6>;
@@ -0,0 +1,107 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#ifdef RT_ENABLE_AUDIO
+#include <aubio/aubio.h>
+#endif
+
+// Hop-by-hop pitch detectors behind one interface, so detection latency and
+// accuracy can be compared offline (see bench/detect_bench.cpp).
+struct PitchDetector {
+  virtual ~PitchDetector() = default;
+  virtual const char* name() const = 0;
+  // Feed one hop of mono samples; returns the current pitch in Hz or 0.
+  virtual float process(const float* hop, unsigned n) = 0;
+};
+
+#ifdef RT_ENABLE_AUDIO
+// The app's detector: aubio "yinfast" with the same window, hop and silence
+// gate as audioCb.
+struct AubioPitchDetector : PitchDetector {
+  aubio_pitch_t* pitch = nullptr;
+  fvec_t* in = nullptr;
+  fvec_t* out = nullptr;
+  unsigned hop;
+
+  AubioPitchDetector(unsigned win, unsigned hopSize, unsigned sampleRate, float silenceDb)
+    : hop(hopSize) {
+    pitch = new_aubio_pitch("yinfast", win, hop, sampleRate);
+    aubio_pitch_set_unit(pitch, "Hz");
+    aubio_pitch_set_silence(pitch, silenceDb);
+    in = new_fvec(hop);
+    out = new_fvec(1);
+  }
+  ~AubioPitchDetector() override {
+    del_aubio_pitch(pitch);
+    del_fvec(in);
+    del_fvec(out);
+  }
+  AubioPitchDetector(const AubioPitchDetector&) = delete;
+  AubioPitchDetector& operator=(const AubioPitchDetector&) = delete;
+
+  const char* name() const override { return "aubio-yinfast"; }
+  float process(const float* samples, unsigned n) override {
+    for (unsigned j = 0; j < hop; ++j) fvec_set_sample(in, j < n ? samples[j] : 0.f, j);
+    aubio_pitch_do(pitch, in, out);
+    float hz = fvec_get_sample(out, 0);
+    return (hz > 20.f && hz < 2000.f) ? hz : 0.f;
+  }
+};
+#endif
+
+// Reference alternative: normalized square difference (McLeod) over a
+// sliding window, taking the first peak within 90% of the best one and
+// refining it with parabolic interpolation. Dependency-free and slower
+// than yinfast; useful as a second opinion in benchmarks.
+struct NsdfPitchDetector : PitchDetector {
+  std::vector<float> window;
+  std::vector<float> nsdf;
+  unsigned minLag, maxLag;
+  float sampleRate;
+  float silence; // linear RMS gate
+
+  NsdfPitchDetector(unsigned win, float sr, float minHz = 60.f, float maxHz = 1400.f, float silenceDb = -50.f)
+    : window(win, 0.f), sampleRate(sr), silence(std::pow(10.f, silenceDb / 20.f)) {
+    minLag = (unsigned)(sr / maxHz);
+    maxLag = std::min<unsigned>((unsigned)(sr / minHz), win / 2);
+    nsdf.assign(maxLag + 2, 0.f);
+  }
+
+  const char* name() const override { return "nsdf"; }
+  float process(const float* samples, unsigned n) override {
+    unsigned w = (unsigned)window.size();
+    n = std::min(n, w);
+    std::move(window.begin() + n, window.end(), window.begin());
+    std::copy(samples, samples + n, window.end() - n);
+
+    float energy = 0.f;
+    for (float v : window) energy += v * v;
+    if (std::sqrt(energy / w) < silence) return 0.f;
+
+    float best = 0.f;
+    for (unsigned lag = minLag; lag <= maxLag + 1; ++lag) {
+      float acf = 0.f, m = 0.f;
+      const float* a = window.data();
+      const float* b = window.data() + lag;
+      unsigned len = w - lag;
+      for (unsigned i = 0; i < len; ++i) {
+        acf += a[i] * b[i];
+        m += a[i] * a[i] + b[i] * b[i];
+      }
+      nsdf[lag] = m > 0.f ? 2.f * acf / m : 0.f;
+      best = std::max(best, nsdf[lag]);
+    }
+    if (best < 0.5f) return 0.f;
+    for (unsigned lag = minLag + 1; lag <= maxLag; ++lag) {
+      if (nsdf[lag] >= 0.9f * best && nsdf[lag] >= nsdf[lag-1] && nsdf[lag] >= nsdf[lag+1]) {
+        float l = nsdf[lag-1], c = nsdf[lag], r = nsdf[lag+1];
+        float denom = l - 2.f * c + r;
+        float shift = denom != 0.f ? 0.5f * (l - r) / denom : 0.f;
+        return sampleRate / ((float)lag + shift);
+      }
+    }
+    return 0.f;
+  }
+};
@@ -0,0 +1,187 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Scoped hot-path profiler.
+//
+// RT_PROFILE_SCOPE("name") records the begin/end time of the enclosing scope
+// into a ring buffer owned by the calling thread. Names must be string
+// literals (they are stored by pointer). While profiling is disabled a scope
+// costs one relaxed atomic load. Each thread's ring is allocated and
+// registered on its first recorded scope and lives until exit, so the
+// overlay and trace export can read other threads' rings at any time.
+// Real-time threads that must not allocate or lock (the audio callback)
+// get a ring up front with addRing() and bind it with useRing().
+// Building with RT_NO_PROFILER compiles the markers out entirely.
+
+struct ProfileEvent {
+  std::atomic<const char*> name{nullptr};
+  std::atomic<uint64_t> beginNs{0};
+  std::atomic<uint64_t> endNs{0};
+};
+
+struct ProfileRing {
+  static constexpr std::size_t kSize = 16384; // power of two
+  std::array<ProfileEvent, kSize> events;
+  std::atomic<uint64_t> head{0}; // total events ever written
+  int tid = 0;
+  std::string threadName;
+};
+
+// One entry of a per-frame summary: total time spent in a named scope.
+struct PhaseTime {
+  const char* name;
+  double ms;
+};
+
+struct Profiler {
+  std::atomic<bool> enabled{false};
+  std::mutex mtx;                                   // guards rings
+  std::vector<std::unique_ptr<ProfileRing>> rings;
+
+  static Profiler& instance() {
+    static Profiler p;
+    return p;
+  }
+
+  static uint64_t nowNs() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  // Allocate and register a ring named `name`, for a thread to bind later.
+  ProfileRing* addRing(const std::string& name) {
+    auto owned = std::make_unique<ProfileRing>();
+    std::lock_guard<std::mutex> lk(mtx);
+    owned->tid = (int)rings.size() + 1;
+    owned->threadName = name.empty() ? "thread " + std::to_string(owned->tid) : name;
+    ProfileRing* ring = owned.get();
+    rings.push_back(std::move(owned));
+    return ring;
+  }
+
+  // Record the calling thread's scopes into `ring` (from addRing). Neither
+  // allocates nor locks.
+  static void useRing(ProfileRing* ring) { localRing() = ring; }
+
+  // The calling thread's ring, registered on first use.
+  ProfileRing& threadRing() {
+    ProfileRing*& ring = localRing();
+    if (!ring) ring = addRing("");
+    return *ring;
+  }
+
+  static ProfileRing*& localRing() {
+    thread_local ProfileRing* ring = nullptr;
+    return ring;
+  }
+
+  void setThreadName(const char* name) {
+    ProfileRing& r = threadRing();
+    std::lock_guard<std::mutex> lk(mtx);
+    r.threadName = name;
+  }
+
+  void record(const char* name, uint64_t beginNs, uint64_t endNs) {
+    ProfileRing& r = threadRing();
+    uint64_t h = r.head.load(std::memory_order_relaxed);
+    ProfileEvent& e = r.events[h & (ProfileRing::kSize - 1)];
+    e.name.store(name, std::memory_order_relaxed);
+    e.beginNs.store(beginNs, std::memory_order_relaxed);
+    e.endNs.store(endNs, std::memory_order_relaxed);
+    r.head.store(h + 1, std::memory_order_release);
+  }
+
+  // Visit every event still held in the rings. Events the writer may have
+  // overwritten while we were reading are dropped.
+  template <class F>
+  void forEachEvent(F&& f) {
+    std::lock_guard<std::mutex> lk(mtx);
+    for (auto& ring : rings) {
+      uint64_t h = ring->head.load(std::memory_order_acquire);
+      uint64_t first = h > ProfileRing::kSize ? h - ProfileRing::kSize : 0;
+      for (uint64_t i = first; i < h; ++i) {
+        const ProfileEvent& e = ring->events[i & (ProfileRing::kSize - 1)];
+        const char* name = e.name.load(std::memory_order_relaxed);
+        uint64_t b = e.beginNs.load(std::memory_order_relaxed);
+        uint64_t en = e.endNs.load(std::memory_order_relaxed);
+        uint64_t h2 = ring->head.load(std::memory_order_acquire);
+        if (h2 > ProfileRing::kSize && i < h2 - ProfileRing::kSize) continue;
+        f(*ring, name, b, en);
+      }
+    }
+  }
+
+  // Sum scope durations per name for events that ended in [fromNs, toNs).
+  // Nested scopes are counted in their parent as well as on their own.
+  void summarize(uint64_t fromNs, uint64_t toNs, std::vector<PhaseTime>& out) {
+    out.clear();
+    forEachEvent([&](const ProfileRing&, const char* name, uint64_t b, uint64_t e){
+      if (!name || e < fromNs || e >= toNs) return;
+      double ms = double(e - b) / 1e6;
+      for (auto& p : out) {
+        if (p.name == name) { p.ms += ms; return; }
+      }
+      out.push_back(PhaseTime{name, ms});
+    });
+  }
+
+  // Write everything in the rings as Chrome trace JSON (chrome://tracing,
+  // Perfetto). Returns false if the file can't be opened.
+  bool writeChromeTrace(const std::string& path) {
+    std::FILE* f = std::fopen(path.c_str(), "w");
+    if (!f) return false;
+    std::fputs("{\"traceEvents\":[\n", f);
+    bool first = true;
+    {
+      std::lock_guard<std::mutex> lk(mtx);
+      for (auto& ring : rings) {
+        std::fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+                        "\"args\":{\"name\":\"%s\"}}",
+                     first ? "" : ",\n", ring->tid, ring->threadName.c_str());
+        first = false;
+      }
+    }
+    forEachEvent([&](const ProfileRing& ring, const char* name, uint64_t b, uint64_t e){
+      if (!name) return;
+      std::fprintf(f, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,"
+                      "\"ts\":%.3f,\"dur\":%.3f}",
+                   first ? "" : ",\n", name, ring.tid, double(b) / 1e3, double(e - b) / 1e3);
+      first = false;
+    });
+    std::fputs("\n]}\n", f);
+    return std::fclose(f) == 0;
+  }
+};
+
+struct ProfileScope {
+  const char* name = nullptr;
+  uint64_t beginNs = 0;
+
+  explicit ProfileScope(const char* n) {
+    if (Profiler::instance().enabled.load(std::memory_order_relaxed)) {
+      name = n;
+      beginNs = Profiler::nowNs();
+    }
+  }
+  ~ProfileScope() {
+    if (name) Profiler::instance().record(name, beginNs, Profiler::nowNs());
+  }
+  ProfileScope(const ProfileScope&) = delete;
+  ProfileScope& operator=(const ProfileScope&) = delete;
+};
+
+#define RT_PROFILE_CONCAT2(a, b) a##b
+#define RT_PROFILE_CONCAT(a, b) RT_PROFILE_CONCAT2(a, b)
+#ifdef RT_NO_PROFILER
+#define RT_PROFILE_SCOPE(name) ((void)0)
+#else
+#define RT_PROFILE_SCOPE(name) ProfileScope RT_PROFILE_CONCAT(rtProfileScope_, __LINE__)(name)
+#endif
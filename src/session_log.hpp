@@ -0,0 +1,392 @@
+#pragma once
+#include "chart.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// Play session logs: everything the simulation read on each tick, so a
+// session can be judged again exactly, at any speed and without audio.
+//
+// A log is a header (magic, version, chart hash and title) followed by one
+// record per tick whose inputs differ from the previous tick's: the tick
+// delta and a field mask as varints, then the changed fields. Integers are
+// zigzag varints, floats are stored bit-exact. A backing track's position
+// is stored only where it departs from advancing at the playback rate, and
+// a detection as its age when it appears, so a steady passage costs a few
+// bytes per detector hop and nothing per tick. An end record carries the
+// tick count and the score the session finished with.
+
+// Inputs to one simulation tick.
+struct TickInput {
+  bool playing = true;
+  double rate = 1.0;         // playback rate
+  int level = -1;            // difficulty requested this tick, -1 if none
+  bool adaptive = false;
+  int latencyOffsetMs = 0;
+  int audioOffsetMs = 0;
+  float hz = 0.f;            // current detection
+  float centroidHz = 0.f;
+  int64_t detectedAtUs = 0;  // clock time its audio was captured, 0 if unknown
+  bool hasTrack = false;
+  int64_t trackUs = -1;      // backing track song position (see BackingTrack::songUsAt)
+};
+
+// FNV-1a over everything judgement depends on, to match a log to its chart.
+inline uint64_t chartHash(const Chart& c) {
+  uint64_t h = 1469598103934665603ull;
+  auto mix = [&](const void* p, std::size_t n) {
+    const unsigned char* b = (const unsigned char*)p;
+    for (std::size_t i = 0; i < n; ++i) { h ^= b[i]; h *= 1099511628211ull; }
+  };
+  auto mixInt = [&](int64_t v) { mix(&v, sizeof(v)); };
+  mixInt(c.strings);
+  for (int t : c.tuning) mixInt(t);
+  mix(&c.bpm, sizeof(c.bpm));
+  for (const TempoChange& t : c.tempo) { mixInt(t.t_ms); mix(&t.bpm, sizeof(t.bpm)); mixInt(t.beatsPerBar); }
+  for (const NoteEvent& n : c.notes) { mixInt(n.t_ms); mixInt(n.str); mixInt(n.fret); mixInt(n.len_ms); mixInt(n.slideTo); }
+  return h;
+}
+
+// Log format constants and the record codec.
+struct SessionLog {
+  static constexpr char kMagic[4] = {'R', 'T', 'S', 'L'};
+  static constexpr uint8_t kVersion = 1;
+  static constexpr int64_t kTickUs = 1000;   // must match Simulation::kTickUs
+  static constexpr std::size_t kMaxRecord = 96; // every field changed
+
+  // Field mask bits.
+  enum : uint32_t {
+    kEnd = 1u << 0,
+    kPlaying = 1u << 1,
+    kRate = 1u << 2,
+    kLevel = 1u << 3,
+    kAdaptive = 1u << 4,
+    kLatency = 1u << 5,
+    kAudioOffset = 1u << 6,
+    kHz = 1u << 7,
+    kCentroid = 1u << 8,
+    kDetected = 1u << 9,
+    kTrack = 1u << 10,
+    kTrackPos = 1u << 11,
+  };
+
+  static uint64_t zigzag(int64_t v) { return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63); }
+  static int64_t unzigzag(uint64_t v) { return (int64_t)(v >> 1) ^ -(int64_t)(v & 1); }
+
+  static uint8_t* putVarint(uint8_t* p, uint64_t v) {
+    while (v >= 0x80) { *p++ = (uint8_t)(v | 0x80); v >>= 7; }
+    *p++ = (uint8_t)v;
+    return p;
+  }
+
+  template <class T>
+  static uint8_t* putRaw(uint8_t* p, T v) {
+    std::memcpy(p, &v, sizeof(v));
+    return p + sizeof(v);
+  }
+
+  struct Reader {
+    const uint8_t* p;
+    const uint8_t* end;
+    bool ok = true;
+
+    uint64_t varint() {
+      uint64_t v = 0;
+      for (int shift = 0; shift < 64; shift += 7) {
+        if (p == end) break;
+        uint8_t b = *p++;
+        v |= (uint64_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) return v;
+      }
+      ok = false;
+      return 0;
+    }
+    template <class T>
+    T raw() {
+      T v{};
+      if (end - p < (std::ptrdiff_t)sizeof(v)) { ok = false; p = end; return v; }
+      std::memcpy(&v, p, sizeof(v));
+      p += sizeof(v);
+      return v;
+    }
+  };
+
+  // Where the track would be after one more tick of `in` from prevUs.
+  static int64_t predictTrack(int64_t prevUs, const TickInput& in) {
+    return prevUs >= 0 && in.playing ? prevUs + std::llround(kTickUs * in.rate) : prevUs;
+  }
+
+  // Encode `in` against `last` (the state after the previous record) at
+  // tick delta dt. Returns the end of the record, or p itself if nothing
+  // changed. tickUs is the tick's clock time, for the detection's age.
+  static uint8_t* encode(uint8_t* p, uint64_t dt, const TickInput& last, const TickInput& in, int64_t tickUs) {
+    uint32_t mask = 0;
+    if (in.playing != last.playing) mask |= kPlaying;
+    if (in.rate != last.rate) mask |= kRate;
+    if (in.level != last.level) mask |= kLevel;
+    if (in.adaptive != last.adaptive) mask |= kAdaptive;
+    if (in.latencyOffsetMs != last.latencyOffsetMs) mask |= kLatency;
+    if (in.audioOffsetMs != last.audioOffsetMs) mask |= kAudioOffset;
+    if (std::memcmp(&in.hz, &last.hz, sizeof(float))) mask |= kHz;
+    if (std::memcmp(&in.centroidHz, &last.centroidHz, sizeof(float))) mask |= kCentroid;
+    if (in.detectedAtUs != last.detectedAtUs) mask |= kDetected;
+    if (in.hasTrack != last.hasTrack) mask |= kTrack;
+    if (in.hasTrack && in.trackUs != predictTrack(last.trackUs, in)) mask |= kTrackPos;
+    if (!mask) return p;
+    p = putVarint(p, dt);
+    p = putVarint(p, mask);
+    if (mask & kPlaying) p = putVarint(p, in.playing);
+    if (mask & kRate) p = putRaw(p, in.rate);
+    if (mask & kLevel) p = putVarint(p, zigzag(in.level));
+    if (mask & kAdaptive) p = putVarint(p, in.adaptive);
+    if (mask & kLatency) p = putVarint(p, zigzag(in.latencyOffsetMs));
+    if (mask & kAudioOffset) p = putVarint(p, zigzag(in.audioOffsetMs));
+    if (mask & kHz) p = putRaw(p, in.hz);
+    if (mask & kCentroid) p = putRaw(p, in.centroidHz);
+    if (mask & kDetected) p = putVarint(p, in.detectedAtUs ? zigzag(tickUs - in.detectedAtUs) + 1 : 0);
+    if (mask & kTrack) p = putVarint(p, in.hasTrack);
+    if (mask & kTrackPos) p = putVarint(p, zigzag(in.trackUs - predictTrack(last.trackUs, in)));
+    return p;
+  }
+
+  // Apply a record's fields (mask already read) to `cur`, the state at the
+  // previous tick, for a tick at clock time tickUs.
+  static void decode(Reader& r, uint32_t mask, TickInput& cur, int64_t tickUs) {
+    int64_t prevTrack = cur.trackUs;
+    if (mask & kPlaying) cur.playing = r.varint() != 0;
+    if (mask & kRate) cur.rate = r.raw<double>();
+    if (mask & kLevel) cur.level = (int)unzigzag(r.varint());
+    if (mask & kAdaptive) cur.adaptive = r.varint() != 0;
+    if (mask & kLatency) cur.latencyOffsetMs = (int)unzigzag(r.varint());
+    if (mask & kAudioOffset) cur.audioOffsetMs = (int)unzigzag(r.varint());
+    if (mask & kHz) cur.hz = r.raw<float>();
+    if (mask & kCentroid) cur.centroidHz = r.raw<float>();
+    if (mask & kDetected) {
+      uint64_t v = r.varint();
+      cur.detectedAtUs = v ? tickUs - unzigzag(v - 1) : 0;
+    }
+    if (mask & kTrack) cur.hasTrack = r.varint() != 0;
+    // Between records the track advances at the rate in force.
+    cur.trackUs = cur.hasTrack ? predictTrack(prevTrack, cur) : -1;
+    if (mask & kTrackPos) cur.trackUs += unzigzag(r.varint());
+  }
+};
+
+// Lock-free single-producer single-consumer byte ring (a power of two).
+struct ByteRing {
+  std::vector<uint8_t> buf;
+  std::size_t mask = 0;
+  std::atomic<uint64_t> head{0}; // bytes ever written
+  std::atomic<uint64_t> tail{0}; // bytes ever read
+
+  explicit ByteRing(std::size_t pow2) : buf(pow2), mask(pow2 - 1) {}
+
+  std::size_t readable() const {
+    return (std::size_t)(head.load(std::memory_order_acquire) - tail.load(std::memory_order_relaxed));
+  }
+  std::size_t writable() const {
+    return buf.size() - (std::size_t)(head.load(std::memory_order_relaxed) - tail.load(std::memory_order_acquire));
+  }
+
+  // Producer: append n bytes if they fit. Returns false (writing nothing) otherwise.
+  bool write(const uint8_t* in, std::size_t n) {
+    if (n > writable()) return false;
+    uint64_t h = head.load(std::memory_order_relaxed);
+    for (std::size_t i = 0; i < n; ++i) buf[(std::size_t)((h + i) & mask)] = in[i];
+    head.store(h + n, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer: hand everything readable to sink(ptr, n) in at most two pieces.
+  template <class Sink>
+  void drain(Sink&& sink) {
+    std::size_t n = readable();
+    uint64_t t = tail.load(std::memory_order_relaxed);
+    std::size_t at = (std::size_t)(t & mask);
+    std::size_t first = std::min(n, buf.size() - at);
+    if (first) sink(buf.data() + at, first);
+    if (n > first) sink(buf.data(), n - first);
+    tail.store(t + n, std::memory_order_release);
+  }
+};
+
+// Writes a session log. The simulation thread calls record() once per tick;
+// it encodes into a lock-free ring and never touches the file, which a
+// background thread appends to every kFlushMs. A full ring drops records
+// (counted in lostBytes) rather than stall the tick.
+struct SessionWriter {
+  static constexpr std::size_t kRingBytes = 1 << 16;
+  static constexpr int kFlushMs = 20;
+
+  ByteRing ring{kRingBytes};
+  std::FILE* file = nullptr;
+  std::thread thread;
+  std::atomic<bool> running{false};
+  std::atomic<uint64_t> lostBytes{0};
+  TickInput last;             // state after the last record, producer side
+  uint64_t ticks = 0;         // ticks recorded
+  uint64_t lastTick = 0;      // tick of the last record
+
+  SessionWriter() = default;
+  SessionWriter(const SessionWriter&) = delete;
+  SessionWriter& operator=(const SessionWriter&) = delete;
+  ~SessionWriter() { close(0, 0); }
+
+  bool isOpen() const { return file != nullptr; }
+
+  bool open(const std::string& path, uint64_t hash, std::string_view title) {
+    close(0, 0);
+    file = std::fopen(path.c_str(), "wb");
+    if (!file) return false;
+    uint8_t head[32];
+    uint8_t* p = head;
+    std::memcpy(p, SessionLog::kMagic, 4);
+    p += 4;
+    *p++ = SessionLog::kVersion;
+    p = SessionLog::putRaw(p, hash);
+    p = SessionLog::putVarint(p, title.size());
+    std::fwrite(head, 1, (std::size_t)(p - head), file);
+    std::fwrite(title.data(), 1, title.size(), file);
+    last = TickInput{};
+    ticks = lastTick = 0;
+    lostBytes.store(0);
+    running.store(true);
+    thread = std::thread([this] {
+      while (running.load(std::memory_order_relaxed)) {
+        flush();
+        std::this_thread::sleep_for(std::chrono::milliseconds(kFlushMs));
+      }
+    });
+    return true;
+  }
+
+  // Producer: the inputs of the next tick, at clock time tickUs.
+  void record(const TickInput& in, int64_t tickUs) {
+    uint8_t rec[SessionLog::kMaxRecord];
+    uint8_t* end = SessionLog::encode(rec, ticks - lastTick, last, in, tickUs);
+    if (end == rec) {
+      last.trackUs = in.trackUs; // unchanged, or the track advanced as predicted
+    } else if (ring.write(rec, (std::size_t)(end - rec))) {
+      // What the reader has after this record.
+      last = in;
+      if (!in.hasTrack) last.trackUs = -1;
+      lastTick = ticks;
+    } else {
+      lostBytes.fetch_add((uint64_t)(end - rec), std::memory_order_relaxed);
+    }
+    ++ticks;
+  }
+
+  // Write the end record with the final score and close the file. Call
+  // once the producer has stopped.
+  void close(uint64_t hits, uint64_t misses) {
+    if (!file) return;
+    running.store(false);
+    if (thread.joinable()) thread.join();
+    uint8_t rec[SessionLog::kMaxRecord];
+    uint8_t* p = SessionLog::putVarint(rec, ticks - lastTick);
+    p = SessionLog::putVarint(p, SessionLog::kEnd);
+    p = SessionLog::putVarint(p, ticks);
+    p = SessionLog::putVarint(p, hits);
+    p = SessionLog::putVarint(p, misses);
+    flush();
+    std::fwrite(rec, 1, (std::size_t)(p - rec), file);
+    std::fclose(file);
+    file = nullptr;
+  }
+
+  void flush() {
+    ring.drain([&](const uint8_t* p, std::size_t n) { std::fwrite(p, 1, n, file); });
+    std::fflush(file);
+  }
+};
+
+// Reads a session log back as a sequence of tick inputs.
+struct SessionReplay {
+  std::vector<uint8_t> data;
+  uint64_t hash = 0;
+  std::string title;
+  // From the end record.
+  uint64_t ticks = 0;
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+  // Cursor.
+  std::size_t body = 0;       // offset of the first record
+  SessionLog::Reader r{nullptr, nullptr};
+  TickInput cur;
+  uint64_t tick = 0;          // ticks handed out
+  uint64_t nextRecord = 0;    // tick of the next record
+  uint32_t nextMask = 0;
+
+  // Load and validate a log. Returns false if it can't be read, isn't a
+  // session log or is cut short.
+  bool load(const std::string& path) {
+    std::FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f) return false;
+    data.clear();
+    uint8_t chunk[4096];
+    std::size_t n;
+    while ((n = std::fread(chunk, 1, sizeof(chunk), f)) > 0) data.insert(data.end(), chunk, chunk + n);
+    std::fclose(f);
+    if (data.size() < 5 || std::memcmp(data.data(), SessionLog::kMagic, 4) || data[4] != SessionLog::kVersion)
+      return false;
+    SessionLog::Reader h{data.data() + 5, data.data() + data.size()};
+    hash = h.raw<uint64_t>();
+    uint64_t len = h.varint();
+    if (!h.ok || len > (uint64_t)(h.end - h.p)) return false;
+    title.assign((const char*)h.p, (std::size_t)len);
+    body = (std::size_t)(h.p - data.data()) + (std::size_t)len;
+    // Walk every record once to check it and find the end record.
+    rewind();
+    while (!finished()) next(0);
+    if (!r.ok) return false;
+    rewind();
+    return true;
+  }
+
+  void rewind() {
+    r = SessionLog::Reader{data.data() + body, data.data() + data.size()};
+    cur = TickInput{};
+    tick = 0;
+    readHeader();
+  }
+
+  // All recorded ticks handed out (or the log is damaged).
+  bool finished() const { return !r.ok || ((nextMask & SessionLog::kEnd) && tick >= nextRecord); }
+
+  // Inputs of the next tick, which runs at clock time tickUs. Past the end
+  // the last inputs repeat, paused.
+  TickInput next(int64_t tickUs) {
+    if (finished()) {
+      cur.playing = false;
+      return cur;
+    }
+    if (tick >= nextRecord) {
+      SessionLog::decode(r, nextMask, cur, tickUs);
+      readHeader();
+    } else if (cur.hasTrack) {
+      cur.trackUs = SessionLog::predictTrack(cur.trackUs, cur);
+    }
+    ++tick;
+    return cur;
+  }
+
+  // Read the next record's tick and mask; an end record's totals as well.
+  void readHeader() {
+    if (!r.ok) return;
+    nextRecord = tick + r.varint();
+    nextMask = (uint32_t)r.varint();
+    if (nextMask & SessionLog::kEnd) {
+      ticks = r.varint();
+      hits = r.varint();
+      misses = r.varint();
+    }
+  }
+};
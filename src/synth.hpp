@@ -0,0 +1,114 @@
+#pragma once
+#include "chart.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+// Karplus-Strong plucked string synthesizer that renders a Chart to mono
+// PCM, for benchmarking and testing pitch detection without audio hardware.
+//
+// There is one voice per string of the active instrument profile, up to
+// kMaxStrings: a fractional delay line with an averaging low-pass in the
+// feedback loop. A new note on a string re-plucks it (like a real guitar),
+// so chords are just notes on different strings at the same time. Notes
+// are damped after their sustain; slides glide the delay length from the
+// start to the target fret over the sustain.
+
+struct SynthOptions {
+  double sampleRate = 48000.0;
+  double decay = 0.996;      // feedback gain while the note rings
+  double releaseDecay = 0.90; // feedback gain after the sustain ends
+  double pickAttack = 0.5;   // 0 = soft/dark pluck, 1 = bright pick attack
+  double noiseDb = -90.0;    // background noise level, dBFS
+  double gain = 0.5;
+  int64_t tailMs = 500;      // rendered after the last note ends
+  uint32_t seed = 1;
+};
+
+struct PluckedString {
+  std::vector<float> line;
+  std::size_t pos = 0;
+  double delay = 100.0;    // samples; current period
+  double delayFrom = 100.0, delayTo = 100.0;
+  int64_t glideLen = 0;    // samples over which delay slides to delayTo
+  int64_t age = 0;         // samples since the pluck
+  int64_t sustain = 0;     // samples before damping kicks in
+  float last = 0.f;
+  bool active = false;
+
+  void pluck(double d, double dTo, int64_t sus, double attack, std::mt19937& rng) {
+    if (line.size() < (std::size_t)std::max(d, dTo) + 4) line.assign((std::size_t)std::max(d, dTo) + 4, 0.f);
+    delay = delayFrom = d;
+    delayTo = dTo;
+    glideLen = dTo != d ? sus : 0;
+    sustain = sus;
+    age = 0;
+    active = true;
+    // Excite with a burst of noise; a one-pole low-pass softens the attack.
+    std::uniform_real_distribution<float> u(-1.f, 1.f);
+    float a = (float)std::clamp(attack, 0.0, 1.0);
+    float lp = 0.f;
+    std::size_t n = (std::size_t)d + 1;
+    for (std::size_t i = 0; i < n; ++i) {
+      lp += (0.15f + 0.85f * a) * (u(rng) - lp);
+      line[(pos + line.size() - n + i) % line.size()] += lp;
+    }
+  }
+
+  float tick(const SynthOptions& opt) {
+    if (!active) return 0.f;
+    if (glideLen > 0 && age < glideLen)
+      delay = delayFrom + (delayTo - delayFrom) * double(age) / double(glideLen);
+    std::size_t size = line.size();
+    double readPos = (double)pos - delay;
+    while (readPos < 0) readPos += (double)size;
+    std::size_t i0 = (std::size_t)readPos % size;
+    std::size_t i1 = (i0 + 1) % size;
+    float frac = (float)(readPos - std::floor(readPos));
+    float delayed = line[i0] * (1.f - frac) + line[i1] * frac;
+    float g = (float)(age < sustain ? opt.decay : opt.releaseDecay);
+    float out = g * 0.5f * (delayed + last);
+    last = delayed;
+    line[pos] = out;
+    pos = (pos + 1) % size;
+    ++age;
+    if (age > sustain && std::abs(out) < 1e-5f) active = false;
+    return out;
+  }
+};
+
+inline double synthMidiToHz(double midi) { return 440.0 * std::pow(2.0, (midi - 69.0) / 12.0); }
+
+// Render chart to mono float PCM at opt.sampleRate.
+inline std::vector<float> renderChartAudio(const Chart& chart, const SynthOptions& opt = {}) {
+  int64_t endMs = 0;
+  for (const auto& n : chart.notes) endMs = std::max(endMs, n.t_ms + n.len_ms);
+  endMs += opt.tailMs;
+  std::size_t total = (std::size_t)(endMs * opt.sampleRate / 1000.0);
+  std::vector<float> out(total, 0.f);
+
+  std::mt19937 rng(opt.seed);
+  std::normal_distribution<float> noise(0.f, 1.f);
+  float noiseAmp = (float)std::pow(10.0, opt.noiseDb / 20.0);
+  std::array<PluckedString, kMaxStrings> strings;
+  std::size_t next = 0;
+  for (std::size_t i = 0; i < total; ++i) {
+    int64_t ms = (int64_t)((double)i * 1000.0 / opt.sampleRate);
+    while (next < chart.notes.size() && chart.notes[next].t_ms <= ms) {
+      const NoteEvent& n = chart.notes[next++];
+      int s = std::clamp(chart.strings - n.str, 0, chart.strings - 1); // 1 = highest -> last index
+      // The averaging filter adds half a sample to the loop period.
+      double d = opt.sampleRate / synthMidiToHz(chart.tuning[s] + n.fret) - 0.5;
+      double dTo = n.slideTo >= 0 ? opt.sampleRate / synthMidiToHz(chart.tuning[s] + n.slideTo) - 0.5 : d;
+      int64_t sus = (int64_t)(std::max<int64_t>(n.len_ms, 1) * opt.sampleRate / 1000.0);
+      strings[s].pluck(d, dTo, sus, opt.pickAttack, rng);
+    }
+    float mix = 0.f;
+    for (auto& st : strings) mix += st.tick(opt);
+    out[i] = (float)opt.gain * mix + noiseAmp * noise(rng);
+  }
+  return out;
+}
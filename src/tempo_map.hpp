@@ -0,0 +1,84 @@
+#pragma once
+#include "chart.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+// A chart's beat grid: beats run at `bpm` in 4/4 from song time 0 (and
+// before it, for count-ins) until the first tempo change, and each change
+// restarts the grid with a bar at its own time. Beat times are computed
+// on the fly from the few changes a chart has, so the map is a cheap view
+// that allocates nothing and can be used from the audio callback.
+struct TempoMap {
+  double bpm = 120.0;
+  const std::vector<TempoChange>* changes = nullptr;
+
+  TempoMap() = default;
+  explicit TempoMap(const Chart& c) : bpm(c.bpm), changes(&c.tempo) {}
+
+  // Call f(us, downbeat) for every beat with song time in [fromUs, toUs), in order.
+  template <class F>
+  void forEachBeat(int64_t fromUs, int64_t toUs, F&& f) const {
+    std::size_t n = changes ? changes->size() : 0;
+    // Segment -1 is the chart bpm from 0; it is hidden by a change at 0.
+    int first = (n > 0 && (*changes)[0].t_ms <= 0) ? 0 : -1;
+    for (int i = first; i < (int)n; ++i) {
+      int64_t segStart = i < 0 ? 0 : (*changes)[i].t_ms * 1000;
+      int64_t segEnd = i + 1 < (int)n ? (*changes)[i + 1].t_ms * 1000 : INT64_MAX;
+      if (segEnd <= fromUs) continue;
+      if (segStart >= toUs) break;
+      double b = i < 0 ? bpm : (*changes)[i].bpm;
+      int bar = i < 0 ? 4 : std::max(1, (*changes)[i].beatsPerBar);
+      if (b <= 0.0) continue;
+      double beatUs = 60e6 / b;
+      // The first segment extends back before its start.
+      int64_t lo = i == first ? fromUs : std::max(fromUs, segStart);
+      int64_t hi = std::min(toUs, segEnd);
+      for (int64_t k = (int64_t)std::ceil((double)(lo - segStart) / beatUs);; ++k) {
+        int64_t t = segStart + (int64_t)std::llround((double)k * beatUs);
+        if (t < lo) continue;
+        if (t >= hi) break;
+        f(t, ((k % bar) + bar) % bar == 0);
+      }
+    }
+  }
+
+  // The tempo in force at song time us: the segment's start, beat length
+  // (0 if the tempo isn't positive) and beats per bar.
+  struct Meter {
+    int64_t startUs = 0;
+    double beatUs = 0.0;
+    int beatsPerBar = 4;
+  };
+
+  Meter meterAt(int64_t us) const {
+    // The last change at or before us, else the chart bpm from 0.
+    int seg = -1;
+    if (changes) {
+      auto after = std::upper_bound(changes->begin(), changes->end(), us,
+                                    [](int64_t t, const TempoChange& c) { return t < c.t_ms * 1000; });
+      seg = (int)(after - changes->begin()) - 1;
+    }
+    double b = seg < 0 ? bpm : (*changes)[seg].bpm;
+    return Meter{seg < 0 ? 0 : (*changes)[seg].t_ms * 1000, b > 0.0 ? 60e6 / b : 0.0,
+                 seg < 0 ? 4 : std::max(1, (*changes)[seg].beatsPerBar)};
+  }
+
+  // Metrical weight of song time us: 0 on a downbeat, 1 on another beat, 2
+  // on an eighth, 3 on a sixteenth and 4 off the grid. A time counts as on a
+  // grid line within 20 ms or a sixteenth of a beat, whichever is less.
+  int strength(int64_t us) const {
+    Meter m = meterAt(us);
+    if (m.beatUs <= 0.0) return 4;
+    double tolUs = std::min(20000.0, m.beatUs / 16.0);
+    double beats = (double)(us - m.startUs) / m.beatUs;
+    for (int div = 1; div <= 4; div *= 2) {
+      double k = std::round(beats * div);
+      if (std::abs(beats * div - k) * m.beatUs / div > tolUs) continue;
+      if (div > 1) return div == 2 ? 2 : 3;
+      int64_t beat = (int64_t)k;
+      return ((beat % m.beatsPerBar) + m.beatsPerBar) % m.beatsPerBar == 0 ? 0 : 1;
+    }
+    return 4;
+  }
+};
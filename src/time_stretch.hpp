@@ -0,0 +1,124 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numbers>
+#include <vector>
+
+// WSOLA (waveform-similarity overlap-add) time-stretcher for interleaved
+// stereo, used to slow backing tracks down without changing their pitch.
+//
+// Output is built from Hann-windowed frames (kFrameMs) overlapped by half.
+// Each new frame is read from near its nominal source position (advancing
+// by hop * rate), shifted within +-kToleranceMs to the offset whose first
+// half best matches the natural continuation of the previous frame, so
+// periodic waveforms join in phase. The search is a coarse pass every
+// kCoarseStep samples refined around the best match. Look-ahead is bounded
+// by one frame plus the tolerance (~40 ms at 48 kHz).
+//
+// The inner loops (dot products with independent partial sums, windowed
+// accumulate) are written so the compiler vectorizes them; no intrinsics.
+struct TimeStretcher {
+  static constexpr double kFrameMs = 32.0;
+  static constexpr double kToleranceMs = 6.0;
+  static constexpr int kCoarseStep = 4;
+
+  int frameLen = 0;   // N, frames
+  int hop = 0;        // N / 2
+  int tol = 0;        // search radius, frames
+  std::vector<float> win;  // Hann, interleaved (2 * N)
+  std::vector<float> in;   // buffered source, interleaved
+  int64_t inBase = 0;      // source frame of in[0]
+  double anaPos = 0.0;     // nominal source frame of the next output frame
+  int64_t prevStart = -1;  // source frame the previous output frame was read from
+  std::vector<float> acc;  // overlap-add accumulator (2 * N)
+
+  // Start stretching at source frame srcFrame.
+  void reset(double sampleRate, int64_t srcFrame) {
+    frameLen = (int)(sampleRate * kFrameMs / 1000.0) & ~1;
+    hop = frameLen / 2;
+    tol = (int)(sampleRate * kToleranceMs / 1000.0);
+    win.resize(2 * (std::size_t)frameLen);
+    for (int i = 0; i < frameLen; ++i) {
+      float w = (float)(0.5 - 0.5 * std::cos(2.0 * std::numbers::pi * i / frameLen)); // periodic: halves sum to 1
+      win[2 * i] = win[2 * i + 1] = w;
+    }
+    acc.assign(2 * (std::size_t)frameLen, 0.f);
+    in.clear();
+    inBase = srcFrame;
+    anaPos = (double)srcFrame;
+    prevStart = -1;
+  }
+
+  void push(const float* stereo, std::size_t frames) { in.insert(in.end(), stereo, stereo + 2 * frames); }
+
+  int64_t inEnd() const { return inBase + (int64_t)(in.size() / 2); }
+
+  // Source frames that must be buffered past inEnd() before the next hop:
+  // a whole frame from the furthest start bestStart() may pick.
+  int64_t needed() const {
+    int64_t want = (int64_t)std::llround(anaPos) + tol + frameLen;
+    if (prevStart >= 0) want = std::max(want, prevStart + hop + frameLen);
+    return std::max<int64_t>(0, want - inEnd());
+  }
+
+  static float dot(const float* a, const float* b, int n) {
+    float s[8] = {};
+    int i = 0;
+    for (; i + 8 <= n; i += 8)
+      for (int k = 0; k < 8; ++k) s[k] += a[i + k] * b[i + k];
+    float t = 0.f;
+    for (; i < n; ++i) t += a[i] * b[i];
+    for (float v : s) t += v;
+    return t;
+  }
+
+  const float* at(int64_t frame) const { return &in[2 * (std::size_t)(frame - inBase)]; }
+
+  // Best read position for the next frame, around its nominal position.
+  int64_t bestStart() const {
+    int64_t nominal = (int64_t)std::llround(anaPos);
+    if (prevStart < 0) return nominal;
+    const float* ref = at(prevStart + hop);
+    int64_t lo = std::max<int64_t>(nominal - tol, inBase);
+    int64_t hi = nominal + tol;
+    int n = 2 * hop;   // first half of the frame, both channels
+    int64_t best = nominal;
+    float bestScore = -1e30f;
+    auto score = [&](int64_t c) {
+      float s = dot(ref, at(c), n);
+      if (s > bestScore) { bestScore = s; best = c; }
+    };
+    for (int64_t c = lo; c <= hi; c += kCoarseStep) score(c);
+    int64_t center = best;
+    for (int64_t c = std::max(lo, center - kCoarseStep + 1); c <= std::min(hi, center + kCoarseStep - 1); ++c)
+      if (c != center) score(c);
+    return best;
+  }
+
+  // Produce one hop of output at playback rate `rate` into out (2 * hop
+  // floats) once enough source is buffered. Returns frames written (0 or
+  // hop); srcFrame receives the nominal source position of the first one.
+  int process(float* out, double rate, double& srcFrame) {
+    if (needed() > 0) return 0;
+    int64_t start = bestStart();
+    const float* x = at(start);
+    const float* w = win.data();
+    float* a = acc.data();
+    int n = 2 * frameLen;
+    for (int i = 0; i < n; ++i) a[i] += w[i] * x[i];
+    std::copy(a, a + 2 * hop, out);
+    std::copy(a + 2 * hop, a + n, a);
+    std::fill(a + n - 2 * hop, a + n, 0.f);
+    srcFrame = anaPos;
+    prevStart = start;
+    anaPos += hop * rate;
+    // Drop source nothing will read again.
+    int64_t keep = std::min<int64_t>((int64_t)anaPos - tol, prevStart + hop);
+    if (keep > inBase) {
+      in.erase(in.begin(), in.begin() + 2 * (std::size_t)(keep - inBase));
+      inBase = keep;
+    }
+    return hop;
+  }
+};
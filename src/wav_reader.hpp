@@ -0,0 +1,113 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Streaming RIFF/WAVE reader: PCM 16/24/32-bit and 32-bit float, any
+// channel count (WAVE_FORMAT_EXTENSIBLE included). Frames are decoded on
+// demand into interleaved floats, so memory use doesn't grow with the file.
+struct WavReader {
+  std::FILE* f = nullptr;
+  int channels = 0;
+  int bits = 0;
+  bool isFloat = false;
+  double sampleRate = 0.0;
+  int64_t totalFrames = 0;
+  int64_t frame = 0;        // next frame to read
+  long dataOffset = 0;
+  std::vector<uint8_t> raw;  // scratch for one read
+
+  WavReader() = default;
+  WavReader(const WavReader&) = delete;
+  WavReader& operator=(const WavReader&) = delete;
+  ~WavReader() { close(); }
+
+  static uint32_t le32(const uint8_t* p) { return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24); }
+  static uint16_t le16(const uint8_t* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+
+  bool open(const std::string& path) {
+    close();
+    f = std::fopen(path.c_str(), "rb");
+    if (!f) return false;
+    uint8_t hdr[12];
+    if (std::fread(hdr, 1, 12, f) != 12 || std::memcmp(hdr, "RIFF", 4) || std::memcmp(hdr + 8, "WAVE", 4)) {
+      close();
+      return false;
+    }
+    bool haveFmt = false;
+    uint8_t ck[8];
+    while (std::fread(ck, 1, 8, f) == 8) {
+      uint32_t size = le32(ck + 4);
+      if (!std::memcmp(ck, "fmt ", 4)) {
+        uint8_t fmt[40] = {};
+        std::size_t n = std::min<uint32_t>(size, sizeof(fmt));
+        if (std::fread(fmt, 1, n, f) != n) break;
+        uint16_t tag = le16(fmt);
+        channels = le16(fmt + 2);
+        sampleRate = le32(fmt + 4);
+        bits = le16(fmt + 14);
+        if (tag == 0xFFFE && n >= 26) tag = le16(fmt + 24); // extensible: subformat GUID
+        isFloat = tag == 3;
+        haveFmt = (tag == 1 && (bits == 16 || bits == 24 || bits == 32)) || (tag == 3 && bits == 32);
+        std::fseek(f, (long)(size - n + (size & 1)), SEEK_CUR);
+      } else if (!std::memcmp(ck, "data", 4)) {
+        if (!haveFmt || channels <= 0) break;
+        dataOffset = std::ftell(f);
+        totalFrames = size / (uint32_t)(channels * bits / 8);
+        frame = 0;
+        return true;
+      } else {
+        std::fseek(f, (long)(size + (size & 1)), SEEK_CUR);
+      }
+    }
+    close();
+    return false;
+  }
+
+  void close() {
+    if (f) std::fclose(f);
+    f = nullptr;
+    channels = 0;
+    totalFrames = frame = 0;
+  }
+
+  bool isOpen() const { return f != nullptr; }
+
+  bool seek(int64_t fr) {
+    if (!f) return false;
+    fr = std::clamp<int64_t>(fr, 0, totalFrames);
+    if (std::fseek(f, dataOffset + (long)(fr * channels * (bits / 8)), SEEK_SET) != 0) return false;
+    frame = fr;
+    return true;
+  }
+
+  // Decode up to `frames` frames into out (channels-interleaved). Returns
+  // the number of frames read; 0 at the end of the data.
+  std::size_t read(float* out, std::size_t frames) {
+    if (!f) return 0;
+    frames = (std::size_t)std::min<int64_t>((int64_t)frames, totalFrames - frame);
+    int bytes = bits / 8;
+    raw.resize(frames * channels * bytes);
+    std::size_t got = std::fread(raw.data(), (std::size_t)(channels * bytes), frames, f);
+    const uint8_t* p = raw.data();
+    for (std::size_t i = 0; i < got * (std::size_t)channels; ++i, p += bytes) {
+      if (isFloat) {
+        float v;
+        std::memcpy(&v, p, 4);
+        out[i] = v;
+      } else if (bits == 16) {
+        out[i] = (float)(int16_t)le16(p) / 32768.f;
+      } else if (bits == 24) {
+        int32_t v = (int32_t)((uint32_t)p[0] << 8 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 24) >> 8;
+        out[i] = (float)v / 8388608.f;
+      } else {
+        out[i] = (float)((double)(int32_t)le32(p) / 2147483648.0);
+      }
+    }
+    frame += (int64_t)got;
+    return got;
+  }
+};
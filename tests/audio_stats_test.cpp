@@ -0,0 +1,27 @@
+#include "../src/audio_stats.hpp"
+#include <cassert>
+
+int main() {
+    AudioStats s;
+    s.sampleRate = 48000.0;
+    // 512 frames at 48 kHz is a 10.67 ms budget.
+    for (int i = 0; i < 98; ++i) s.record(0, 100, 512);
+    s.record(AudioStats::kInputOverflow, 3000, 512);
+    s.record(AudioStats::kInputUnderflow | AudioStats::kOutputUnderflow, 12000, 512);
+
+    assert(s.callbacks.load() == 100);
+    assert(s.inputOverflows.load() == 1);
+    assert(s.inputUnderflows.load() == 1);
+    assert(s.outputUnderflows.load() == 1);
+    assert(s.outputOverflows.load() == 0);
+    assert(s.xruns() == 3);
+    assert(s.overBudget.load() == 1);
+    assert(s.maxUs.load() == 12000);
+
+    // 100 us lands in [64,128); the median reports that bucket's upper bound.
+    assert(s.percentileUs(50) == 127);
+    assert(s.percentileUs(99) >= 3000 && s.percentileUs(99) < 4096);
+    assert(s.percentileUs(100) >= 12000);
+    assert(s.meanUs() > 100.0);
+    return 0;
+}
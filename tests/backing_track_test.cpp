@@ -0,0 +1,179 @@
+#include "../src/backing_track.hpp"
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+
+// Write a WAV file: 16-bit PCM or 32-bit float, interleaved samples.
+static void writeWav(const char* path, int channels, int rate, bool isFloat, const std::vector<float>& s) {
+    std::FILE* f = std::fopen(path, "wb");
+    assert(f);
+    auto u32 = [&](uint32_t v){ std::fwrite(&v, 4, 1, f); };
+    auto u16 = [&](uint16_t v){ std::fwrite(&v, 2, 1, f); };
+    int bytes = isFloat ? 4 : 2;
+    uint32_t data = (uint32_t)(s.size() * bytes);
+    std::fwrite("RIFF", 1, 4, f); u32(36 + 8 + data); std::fwrite("WAVE", 1, 4, f);
+    std::fwrite("LIST", 1, 4, f); u32(4); std::fwrite("INFO", 1, 4, f); // skipped chunk
+    std::fwrite("fmt ", 1, 4, f); u32(16); u16(isFloat ? 3 : 1); u16((uint16_t)channels);
+    u32((uint32_t)rate); u32((uint32_t)(rate * channels * bytes)); u16((uint16_t)(channels * bytes)); u16((uint16_t)(bytes * 8));
+    std::fwrite("data", 1, 4, f); u32(data);
+    for (float v : s) {
+        if (isFloat) std::fwrite(&v, 4, 1, f);
+        else { int16_t q = (int16_t)std::lround(v * 32767.f); std::fwrite(&q, 2, 1, f); }
+    }
+    std::fclose(f);
+}
+
+// Wait for the decoder thread to reach a state, however slow it runs
+// (sanitizers, a loaded machine); a minute without progress is a hang.
+template <class F>
+static void waitFor(F&& done) {
+    for (int i = 0; !done(); ++i) {
+        assert(i < 60000);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+// True when a mix() of n frames can't starve: the ring holds them (and
+// enough to start playing), the track has ended, or a rewind is waiting for
+// the callback to drop the ring.
+static bool readyFor(const BackingTrack& t, std::size_t n) {
+    std::size_t r = t.ring.readable();
+    bool enough = r >= n && (t.primed.load() || r >= BackingTrack::kPrimeFrames);
+    return enough || t.eof.load() || t.flushReq.load() != t.flushAck.load();
+}
+
+// Pull `frames` frames through mix() in 128-frame callbacks, like the
+// audio thread would (`dacUs` advancing by one buffer per call). Each call
+// waits on the ring rather than sleeping, so the decoder never falls behind
+// the simulated clock and the results don't depend on scheduling.
+static std::vector<float> pull(BackingTrack& t, std::size_t frames, int channels, int64_t& dacUs) {
+    std::vector<float> out(frames * channels, 0.f);
+    for (std::size_t i = 0; i < frames; i += 128) {
+        std::size_t n = std::min<std::size_t>(128, frames - i);
+        waitFor([&]{ return readyFor(t, n); });
+        t.mix(&out[i * channels], n, channels, dacUs);
+        dacUs += (int64_t)std::llround(n * 1e6 / t.streamRate);
+    }
+    return out;
+}
+
+static void waitPrimed(BackingTrack& t) {
+    waitFor([&]{ return t.ring.readable() >= BackingTrack::kPrimeFrames; });
+}
+
+// Rate of the block the callback is playing.
+static double playingRate(const BackingTrack& t) {
+    return t.markers[t.markerCur % BackingTrack::kMarkers].rate;
+}
+
+int main() {
+    // 16-bit stereo: the reader returns the samples written.
+    const int rate = 48000;
+    const std::size_t frames = 5 * rate; // longer than the ring
+    std::vector<float> pcm(frames * 2);
+    for (std::size_t i = 0; i < frames; ++i) {
+        pcm[2 * i] = 0.5f * std::sin(0.01f * (float)i);
+        pcm[2 * i + 1] = -pcm[2 * i];
+    }
+    writeWav("bt_stereo.wav", 2, rate, false, pcm);
+    {
+        WavReader r;
+        assert(r.open("bt_stereo.wav"));
+        assert(r.channels == 2 && r.sampleRate == rate && r.totalFrames == (int64_t)frames);
+        std::vector<float> buf(200);
+        assert(r.read(buf.data(), 100) == 100);
+        for (int i = 0; i < 200; ++i) assert(std::abs(buf[i] - pcm[i]) < 1e-4f);
+        assert(r.seek((int64_t)frames - 10));
+        assert(r.read(buf.data(), 100) == 10);
+        assert(r.read(buf.data(), 100) == 0);
+    }
+    assert(!WavReader{}.open("does_not_exist.wav"));
+
+    // Streaming at the file's rate is sample exact through 128-frame
+    // callbacks, and the ring never grows. Every callback finds its frames
+    // buffered, so there are no underruns.
+    BackingTrack t;
+    assert(t.open("bt_stereo.wav", rate));
+    assert(t.songUsAt(0) == -1);
+    t.playing.store(true);
+    waitPrimed(t);
+    int64_t dac = 1000000;
+    std::vector<float> out = pull(t, frames, 2, dac);
+    for (std::size_t i = 0; i < frames * 2; ++i) assert(std::abs(out[i] - pcm[i]) < 1e-4f);
+    assert(t.underruns.load() == 0);
+    assert(t.ring.capacity() == BackingTrack::kRingFrames);
+    // The published position maps play-clock time to track time.
+    int64_t lastDac = dac - (int64_t)std::llround(128 * 1e6 / rate);
+    assert(std::llabs(t.songUsAt(lastDac) - (int64_t)(frames - 128) * 1000000 / rate) <= 1);
+    assert(std::llabs(t.songUsAt(lastDac + 5000) - t.songUsAt(lastDac) - 5000) <= 1);
+
+    // Past the end the song keeps going in silence.
+    out = pull(t, 1024, 2, dac);
+    for (float v : out) assert(v == 0.f);
+    assert(t.underruns.load() == 0);
+
+    // Paused: nothing is consumed and the position doesn't move.
+    t.restart();
+    assert(t.songUsAt(dac) == -1);
+    waitFor([&]{ return t.flushReq.load() != t.flushAck.load(); });
+    out = pull(t, 128, 2, dac);          // acknowledges the rewind
+    assert(t.flushReq.load() == t.flushAck.load());
+    waitPrimed(t);
+    t.playing.store(false);
+    out = pull(t, 1024, 2, dac);
+    for (float v : out) assert(v == 0.f);
+    assert(std::llabs(t.songUsAt(dac - (int64_t)std::llround(128 * 1e6 / rate))) <= 1);
+    t.playing.store(true);
+    out = pull(t, 256, 2, dac);
+    for (std::size_t i = 0; i < 512; ++i) assert(std::abs(out[i] - pcm[i]) < 1e-4f);
+
+    // Mono output downmixes (the two channels cancel here).
+    out = pull(t, 256, 1, dac);
+    for (float v : out) assert(std::abs(v) < 1e-4f);
+
+    // Half speed: after the ring drains of 1x audio, the published position
+    // advances at half the play-clock rate; back at 1x it runs at full rate.
+    t.setRate(0.25);
+    assert(t.rate.load() == BackingTrack::kMinRate);
+    t.setRate(0.5);
+    // Everything made at 1x fits in the ring, so this drains it.
+    pull(t, BackingTrack::kRingFrames + 4096, 2, dac);
+    assert(playingRate(t) == 0.5);
+    int64_t p0 = t.songUsAt(dac);
+    pull(t, 9600, 2, dac);
+    int64_t p1 = t.songUsAt(dac);
+    assert(std::llabs((p1 - p0) - 100000) < 2000);
+    assert(std::llabs(t.songUsAt(dac + 10000) - p1 - 5000) <= 1);
+    t.setRate(1.0);
+    pull(t, BackingTrack::kRingFrames + 4096, 2, dac);
+    assert(playingRate(t) == 1.0);
+    p0 = t.songUsAt(dac);
+    pull(t, 9600, 2, dac);
+    assert(std::llabs((t.songUsAt(dac) - p0) - 200000) < 2000);
+    assert(t.underruns.load() == 0);
+    t.close();
+
+    // A 24 kHz mono float file played on a 48 kHz stream is resampled:
+    // twice the frames, interpolated halfway between source samples.
+    std::vector<float> ramp(2400);
+    for (std::size_t i = 0; i < ramp.size(); ++i) ramp[i] = (float)i / 4096.f;
+    writeWav("bt_mono.wav", 1, 24000, true, ramp);
+    BackingTrack m;
+    assert(m.open("bt_mono.wav", 48000));
+    assert(std::abs(m.durationSec() - 0.1) < 1e-9);
+    m.playing.store(true);
+    waitFor([&]{ return m.eof.load(); }); // shorter than kPrimeFrames: plays once it's all decoded
+    dac = 0;
+    out = pull(m, 4800, 2, dac);
+    for (std::size_t i = 0; i + 2 < 4800; ++i) {
+        float expect = (float)i / 2.f / 4096.f;
+        assert(std::abs(out[2 * i] - expect) < 1e-5f);
+        assert(out[2 * i] == out[2 * i + 1]);
+    }
+    m.close();
+
+    std::remove("bt_stereo.wav");
+    std::remove("bt_mono.wav");
+    return 0;
+}
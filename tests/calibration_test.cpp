@@ -0,0 +1,95 @@
+#include "../src/calibration.hpp"
+#include "../src/synth.hpp"
+#include <cassert>
+#include <cmath>
+#include <random>
+
+int main() {
+    const double sr = 48000.0;
+
+    // Clicks mixed buffer by buffer land on their beats, and the onset
+    // detector finds them to within a sample (loopback with no latency).
+    BeatSchedule sched{100000, 250000, 8};
+    std::vector<float> click = makeClick(sr);
+    std::vector<float> pcm((std::size_t)(2.5 * sr), 0.f);
+    const std::size_t buf = 256;
+    for (std::size_t i = 0; i < pcm.size(); i += buf) {
+        int64_t t0 = (int64_t)std::llround((double)i * 1e6 / sr);
+        mixClicks(&pcm[i], std::min(buf, pcm.size() - i), 1, t0, sr, sched, click);
+    }
+    OnsetDetector det;
+    std::vector<int64_t> onsets;
+    for (std::size_t i = 0; i < pcm.size(); i += buf) {
+        int64_t t0 = (int64_t)std::llround((double)i * 1e6 / sr);
+        det.process(&pcm[i], std::min(buf, pcm.size() - i), t0, sr, [&](int64_t us){ onsets.push_back(us); });
+    }
+    assert(onsets.size() == 8);
+    for (int k = 0; k < 8; ++k) assert(std::llabs(onsets[k] - sched.timeOf(k)) <= 50);
+
+    // Stereo mixing writes both channels.
+    std::vector<float> st(2 * 64, 0.f);
+    mixClicks(st.data(), 64, 2, 100000 - 500, sr, sched, click);
+    bool any = false;
+    for (int i = 0; i < 64; ++i) { assert(st[2 * i] == st[2 * i + 1]); any |= st[2 * i] != 0.f; }
+    assert(any);
+
+    // A player plucking ~23 ms behind the beat, with human jitter, one
+    // missed beat and one stray double pluck.
+    Calibrator cal;
+    cal.begin(0, false);
+    std::mt19937 rng(3);
+    std::normal_distribution<double> human(0.0, 6.0);
+    Chart chart;
+    for (int k = 0; k < cal.sched.count; ++k) {
+        if (k == 9) continue;
+        NoteEvent n{};
+        n.t_ms = (int64_t)std::llround((double)cal.sched.timeOf(k) / 1000.0 + 23.0 + human(rng));
+        n.str = 6; n.fret = 0; n.len_ms = 120;
+        chart.notes.push_back(n);
+        if (k == 12) { n.t_ms += 200; chart.notes.push_back(n); }
+    }
+    SynthOptions opt;
+    opt.sampleRate = sr;
+    opt.noiseDb = -60.0;
+    pcm = renderChartAudio(chart, opt);
+    OnsetDetector pluckDet;
+    for (std::size_t i = 0; i < pcm.size(); i += buf) {
+        int64_t t0 = (int64_t)std::llround((double)i * 1e6 / sr);
+        pluckDet.process(&pcm[i], std::min(buf, pcm.size() - i), t0, sr, [&](int64_t us){ cal.addOnset(us); });
+    }
+    assert(!cal.update(cal.sched.timeOf(cal.sched.count - 1)));
+    assert(cal.update(cal.sched.endUs()));
+    assert(cal.audio.ok);
+    assert(cal.audio.used >= 14);
+    assert(std::abs(cal.audio.offsetMs - 23.0) < 4.0);
+    assert(cal.phase == Calibrator::Phase::Visual);
+
+    // Visual pass: answers come 40 ms later than the audio ones, plus one
+    // wild outlier that the median filter rejects.
+    int64_t v0 = cal.sched.startUs;
+    assert(!cal.flashing(v0 - 1000) && cal.flashing(v0 + 1000) && !cal.flashing(v0 + Calibrator::kFlashUs));
+    for (int k = 0; k < cal.sched.count; ++k) {
+        int64_t late = k == 10 ? 250000 : 63000 + (k % 3 - 1) * 4000;
+        cal.addOnset(cal.sched.timeOf(k) + late);
+    }
+    assert(cal.update(cal.sched.endUs()));
+    assert(cal.phase == Calibrator::Phase::Done);
+    assert(cal.ok());
+    assert(cal.visual.used == Calibrator::kBeats - 1);
+    assert(std::abs(cal.visualOffsetMs() - 40) <= 4);
+
+    // Nobody answering is reported as a failure, not a zero offset.
+    cal.begin(0, true);
+    assert(cal.update(cal.sched.endUs()));
+    assert(cal.phase == Calibrator::Phase::Done);
+    assert(!cal.ok());
+
+    // Onset queue: FIFO, bounded.
+    OnsetQueue q;
+    for (int i = 0; i < (int)OnsetQueue::kSize; ++i) assert(q.push(i));
+    assert(!q.push(999));
+    int64_t v;
+    for (int i = 0; i < (int)OnsetQueue::kSize; ++i) { assert(q.pop(v)); assert(v == i); }
+    assert(!q.pop(v));
+    return 0;
+}
@@ -0,0 +1,56 @@
+#include "../src/clock.hpp"
+#include <cassert>
+#include <cstdlib>
+#include <random>
+
+int main() {
+    // Manual and scaled clocks.
+    ManualClock m;
+    assert(m.nowUs() == 0);
+    m.advanceUs(1500);
+    assert(m.nowUs() == 1500);
+    ScaledClock fast(m, 4.0);
+    m.advanceUs(1000);
+    assert(fast.nowUs() == 4000);
+
+    // Unobserved, a synced clock is its local clock.
+    ManualClock local;
+    local.setUs(2000000);
+    SyncedClock synced(local);
+    assert(synced.nowUs() == 2000000);
+
+    // A 10-minute song against an audio clock 500 ppm fast that starts at an
+    // unrelated origin and is observed every 10 ms with +-1 ms of jitter.
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> jitter(-1000, 1000);
+    const double drift = 1.0005;
+    const int64_t refOrigin = 123456789;
+    auto refAt = [&](int64_t l) { return refOrigin + (int64_t)((double)(l - 2000000) * drift); };
+    synced.observe(refAt(local.nowUs()));
+    assert(synced.nowUs() == 2000000);             // no jump on first sync
+    int64_t prev = synced.nowUs();
+    int64_t worst = 0;
+    for (int i = 0; i < 60000; ++i) {
+        for (int k = 0; k < 10; ++k) {
+            local.advanceUs(1000);
+            int64_t now = synced.nowUs();
+            assert(now >= prev);                   // smooth: never steps back
+            prev = now;
+        }
+        synced.observe(refAt(local.nowUs()) + jitter(rng));
+        if (i > 3000) {
+            int64_t err = synced.nowUs() - synced.fromReferenceUs(refAt(local.nowUs()));
+            worst = std::max<int64_t>(worst, std::llabs(err));
+        }
+    }
+    // Uncorrected the local clock would be 300 ms behind by now.
+    assert(worst < 1000);
+    assert(std::abs(synced.anchor.rate.load() - drift) < 0.0003);
+
+    // A stream restart re-bases without a visible jump.
+    int64_t before = synced.nowUs();
+    synced.observe(5000);
+    assert(std::llabs(synced.nowUs() - before) < 10);
+    assert(synced.fromReferenceUs(5000) == synced.nowUs());
+    return 0;
+}
@@ -0,0 +1,107 @@
+#include "../src/compiled_chart.hpp"
+#include <cassert>
+
+int main() {
+    Chart chart;
+    NoteEvent n{};
+    n.t_ms = 0; n.str = 6; n.fret = 3; n.len_ms = 500;
+    chart.notes.push_back(n);
+    n.t_ms = 500; n.str = 1; n.fret = 5; n.len_ms = 1000; n.slideTo = 7;
+    chart.notes.push_back(n);
+    n.t_ms = 900; n.str = 7; n.fret = 0; n.len_ms = 0; n.slideTo = -1; // no 7th string on a guitar
+    chart.notes.push_back(n);
+
+    // Pitch attributes: lane (0 = lowest string), colour slot and expected MIDI.
+    CompiledChart cc;
+    assert(cc.sync(chart));
+    assert(cc.notes.size() == 3);
+    assert(cc.notes[0].lane == 0 && cc.notes[0].colorIdx == 0 && cc.notes[0].midi == 43);
+    assert(cc.notes[1].lane == 5 && cc.notes[1].colorIdx == 5 && cc.notes[1].midi == 69);
+    assert(cc.notes[1].hz > 439.9f && cc.notes[1].hz < 440.1f);
+    assert(cc.notes[2].lane == 0 && cc.notes[2].midi == -1);
+
+    // Pixel attributes at the current zoom.
+    assert(cc.layout(0.25, 3.0));
+    assert(cc.placed(0).lenPx == 125.f && cc.placed(0).slideDy == 0.f);
+    assert(cc.placed(1).lenPx == 250.f && cc.placed(1).slideDy == 6.f);
+
+    // Nothing changed: both are no-ops.
+    assert(!cc.sync(chart));
+    assert(!cc.layout(0.25, 3.0));
+
+    // Zoom or lane size changes redo only the layout, and only for the notes
+    // that are placed again.
+    assert(cc.layout(0.5, 3.0));
+    assert(cc.notes[1].lenPx == 250.f);
+    assert(cc.placed(1).lenPx == 500.f);
+    assert(cc.notes[0].lenPx == 125.f);
+    assert(cc.layout(0.5, 1.0));
+    assert(cc.placed(1).lenPx == 500.f && cc.placed(1).slideDy == 2.f);
+    assert(!cc.sync(chart));
+
+    // A tuning change recompiles pitches and invalidates the layout.
+    chart.tuning[5] = 62; // high string down to D
+    assert(cc.sync(chart));
+    assert(cc.notes[1].midi == 67);
+    assert(cc.layout(0.5, 3.0));
+    assert(cc.placed(1).slideDy == 6.f);
+
+    // So does a different instrument or more notes.
+    chart.strings = 7;
+    chart.tuning = {35, 40, 45, 50, 55, 59, 64};
+    assert(cc.sync(chart));
+    assert(cc.notes[2].lane == 0 && cc.notes[2].midi == 35 && cc.notes[2].colorIdx == 6);
+    assert(cc.notes[0].lane == 1);
+    chart.notes.push_back(n);
+    assert(cc.sync(chart) && cc.notes.size() == 4);
+
+    // Difficulty layers at 120 bpm (a beat every 500 ms).
+    Chart song;
+    auto add = [&](int64_t t, int str, int fret) {
+        NoteEvent e{};
+        e.t_ms = t; e.str = str; e.fret = fret; e.len_ms = 100;
+        song.notes.push_back(e);
+    };
+    add(0, 5, 3); add(0, 4, 5); add(0, 3, 5);  // downbeat chord, root on string 5
+    add(250, 3, 7);                            // eighth
+    add(375, 2, 8);                            // sixteenth
+    add(420, 1, 3);                            // off the grid
+    add(500, 2, 15);                           // beat, high up the neck
+    add(1000, 1, 20);                          // beat, higher still
+    CompiledChart lc;
+    assert(lc.sync(song));
+    auto ids = [&](int level) { return std::vector<uint32_t>(lc.layer(level).begin(), lc.layer(level).end()); };
+    assert(ids(3) == (std::vector<uint32_t>{0, 1, 2, 3, 4, 5, 6, 7}));
+    assert(ids(2) == (std::vector<uint32_t>{0, 1, 3, 4, 6, 7}));
+    assert(ids(1) == (std::vector<uint32_t>{0, 3, 6}));
+    assert(ids(0) == (std::vector<uint32_t>{0}));
+    assert(&lc.layer(-1) == &lc.layer(0) && &lc.layer(9) == &lc.layer(3));
+
+    // A cursor keeps its place when the level changes.
+    assert(lc.remap(0, 3, 0) == 0);
+    assert(lc.remap(3, 3, 1) == 1);  // note 3 is Medium's second
+    assert(lc.remap(4, 3, 1) == 2);  // note 4 isn't in Medium; the next one is
+    assert(lc.remap(5, 3, 0) == 1);  // past Easy's last note
+    assert(lc.remap(1, 0, 3) == 8);  // finished stays finished
+    assert(lc.remap(2, 1, 2) == 4);  // note 6 is Hard's fifth
+
+    // Phrases: the notes up to 1 s run together; a rest of a beat starts a
+    // new one, and so does a downbeat after four bars of continuous notes.
+    assert(lc.phraseStarts == (std::vector<uint32_t>{0}));
+    assert(lc.notes[7].phrase == 0);
+    add(2000, 5, 0);                               // after a 900 ms rest
+    for (int64_t t = 2250; t <= 11000; t += 250) add(t, 5, 2);
+    Chart longer = song;
+    assert(lc.sync(longer));
+    assert(lc.phraseStarts.size() == 3);
+    assert(lc.phraseStarts[1] == 8 && longer.notes[lc.phraseStarts[2]].t_ms == 10000);
+    assert(lc.notes[8].phrase == 1 && lc.notes[lc.phraseStarts[2] - 1].phrase == 1);
+    song.notes.resize(8);
+
+    // Recompiling for another chart rebuilds the layers.
+    Chart lower = song;
+    lower.notes[6].fret = 5;
+    assert(lc.sync(lower));
+    assert(ids(0) == (std::vector<uint32_t>{0, 6}));
+    return 0;
+}
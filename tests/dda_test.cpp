@@ -0,0 +1,34 @@
+#include "../src/dda.hpp"
+#include <cassert>
+
+int main() {
+    DifficultyAdjuster d;
+    assert(d.hitRate() == 1.f && d.meanErrorMs() == 0.f);
+    assert(d.verdict() == 0);
+
+    // Clean, tight play: harder, but only once enough notes are in.
+    for (int i = 0; i < DifficultyAdjuster::kMinNotes - 1; ++i) d.record(true, i % 2 ? 10.0 : -10.0);
+    assert(d.verdict() == 0);
+    d.record(true, 10.0);
+    assert(d.meanErrorMs() == 10.f && d.verdict() == 1);
+    d.changed();
+    assert(d.verdict() == 0);
+
+    // The window rolls: after kWindow misses nothing of the hits is left.
+    for (int i = 0; i < DifficultyAdjuster::kWindow; ++i) d.record(false, 0.0);
+    assert(d.count == DifficultyAdjuster::kWindow && d.hits == 0 && d.errorSum == 0);
+    assert(d.hitRate() == 0.f && d.verdict() == -1);
+
+    // Half hits: neither harder nor easier than the thresholds allow.
+    DifficultyAdjuster h;
+    for (int i = 0; i < DifficultyAdjuster::kWindow; ++i) h.record(true, 20.0);
+    for (int i = 0; i < DifficultyAdjuster::kWindow / 4; ++i) h.record(false, 0.0);
+    assert(h.hits == 24 && h.count == 32 && h.meanErrorMs() == 20.f);
+    assert(h.hitRate() == 0.75f && h.verdict() == 0);
+
+    // Hitting everything but late is still too hard.
+    DifficultyAdjuster late;
+    for (int i = 0; i < DifficultyAdjuster::kMinNotes; ++i) late.record(true, 90.0);
+    assert(late.hitRate() == 1.f && late.verdict() == -1);
+    return 0;
+}
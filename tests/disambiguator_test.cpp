@@ -0,0 +1,87 @@
+#include "../src/disambiguator.hpp"
+#include <cassert>
+#include <cmath>
+#include <numbers>
+#include <vector>
+
+static double midiHz(int midi) { return 440.0 * std::pow(2.0, (midi - 69) / 12.0); }
+
+int main() {
+    // The centroid of a pure tone is its frequency (to within the bias of a
+    // block that isn't a whole number of periods).
+    {
+        const double sr = 48000.0;
+        std::vector<float> x(512);
+        for (std::size_t i = 0; i < x.size(); ++i) x[i] = (float)std::sin(2.0 * std::numbers::pi * 440.0 * i / sr);
+        assert(std::abs(spectralCentroidHz(x.data(), x.size(), sr) - 440.0f) < 9.0f);
+        std::vector<float> silence(512, 0.f);
+        assert(spectralCentroidHz(silence.data(), silence.size(), sr) == 0.f);
+    }
+
+    NoteTable table;
+    const int e4 = 64;
+
+    // E4 expected on the B string, 5th fret: that position wins over the
+    // default lowest string.
+    {
+        PositionDisambiguator pd;
+        NoteEvent n{};
+        n.str = 2; n.fret = 5;
+        NoteTable::Position p = pd.choose(table, e4, &n, midiHz(e4), 0.f);
+        assert(p.stringIdx == 4 && p.fret == 5);
+        // Nothing expected and no hand position yet: the lowest string.
+        p = pd.choose(table, e4, nullptr, midiHz(e4), 0.f);
+        assert(p.stringIdx == 0 && p.fret == 24);
+    }
+
+    // The hand's recent position decides when the chart doesn't: after
+    // notes around the 10th fret, A4 is taken on the B string, 10th fret.
+    {
+        PositionDisambiguator pd;
+        pd.confirm(NoteTable::Position{3, 9}, 0.0, 0.f);
+        pd.confirm(NoteTable::Position{4, 11}, 0.0, 0.f);
+        NoteTable::Position p = pd.choose(table, 69, nullptr, midiHz(69), 0.f);
+        assert(p.stringIdx == 4 && p.fret == 10);
+        // Open strings cost nothing to reach.
+        p = pd.choose(table, 64, nullptr, midiHz(64), 0.f);
+        assert(p.stringIdx == 5 && p.fret == 0);
+    }
+
+    // Timbre: once learned, a much darker tone than an open string has
+    // overrides an expected open position.
+    {
+        PositionDisambiguator pd;
+        double hz = midiHz(e4);
+        float open = (float)(hz * 4.0); // open strings: centroid two octaves up
+        for (int i = 0; i < PositionDisambiguator::kTimbreNotes; ++i)
+            pd.confirm(NoteTable::Position{5, 0}, hz, open);
+        NoteEvent n{};
+        n.str = 1; n.fret = 0;
+        assert(pd.choose(table, e4, &n, hz, open).stringIdx == 5);
+        // The same pitch at the brightness 24 frets up (two octaves darker).
+        NoteTable::Position p = pd.choose(table, e4, &n, hz, (float)hz);
+        assert(p.stringIdx == 0 && p.fret == 24);
+    }
+
+    // Repeated questions are answered from the cache; learning invalidates it.
+    {
+        PositionDisambiguator pd;
+        NoteEvent n{};
+        n.str = 3; n.fret = 9;
+        NoteTable::Position a = pd.choose(table, e4, &n, midiHz(e4), 0.f);
+        uint32_t v = pd.cVersion;
+        NoteTable::Position b = pd.choose(table, e4, &n, midiHz(e4), 0.f);
+        assert(a.stringIdx == b.stringIdx && a.fret == b.fret && pd.cVersion == v);
+        pd.confirm(a, 0.0, 0.f);
+        pd.choose(table, e4, &n, midiHz(e4), 0.f);
+        assert(pd.cVersion == pd.version && pd.cVersion != v);
+    }
+
+    // Pitches the tuning can't play have no position.
+    {
+        PositionDisambiguator pd;
+        NoteTable::Position p = pd.choose(table, 28, nullptr, midiHz(28), 0.f);
+        assert(p.stringIdx == -1 && p.fret == -1);
+    }
+    return 0;
+}
@@ -0,0 +1,40 @@
+#include "../src/frame_pacer.hpp"
+#include <cassert>
+
+int main() {
+    // Vsync already paces at the display rate; don't sleep on top of it.
+    FramePacer p;
+    p.configure(60, true, 60);
+    assert(!p.active());
+    p.configure(144, true, 60);
+    assert(!p.active());
+    p.configure(30, true, 60);
+    assert(p.active());
+    p.configure(0, false, 60); // unlimited
+    assert(!p.active());
+    p.configure(120, false, 0);
+    assert(p.active());
+
+    // Ten paced frames at 100 fps with no work take at least ~100 ms. No
+    // upper bound: real sleeps overshoot arbitrarily on a loaded machine.
+    p.configure(100, false, 0);
+    Uint64 start = SDL_GetPerformanceCounter();
+    for (int i = 0; i < 10; ++i) {
+        p.beginFrame();
+        p.wait();
+    }
+    double ms = double(SDL_GetPerformanceCounter() - start) * 1000.0 / double(SDL_GetPerformanceFrequency());
+    assert(ms >= 95.0);
+
+    // A frame that overruns its deadline resets the schedule instead of
+    // making the next frames return immediately.
+    p.beginFrame();
+    SDL_Delay(50);
+    p.wait();
+    Uint64 before = SDL_GetPerformanceCounter();
+    p.beginFrame();
+    p.wait();
+    double next = double(SDL_GetPerformanceCounter() - before) * 1000.0 / double(SDL_GetPerformanceFrequency());
+    assert(next >= 5.0);
+    return 0;
+}
@@ -0,0 +1,45 @@
+#include "../src/frame_stats.hpp"
+#include <cassert>
+#include <cmath>
+#include <fstream>
+
+static bool near(double a, double b, double rel) { return std::abs(a - b) <= b * rel; }
+
+int main() {
+    FrameStats s;
+    assert(s.percentile(50) == 0.0);
+
+    // 1000 frames: 900 at ~16.7 ms, 90 at 20 ms, 10 hitches at 50 ms.
+    for (int i = 0; i < 900; ++i) s.record(16.7);
+    for (int i = 0; i < 90; ++i) s.record(20.0);
+    for (int i = 0; i < 10; ++i) s.record(50.0);
+    assert(s.total == 1000);
+    assert(near(s.percentile(50), 16.7, 0.02));
+    assert(near(s.percentile(95), 20.0, 0.02));
+    assert(near(s.percentile(99), 20.0, 0.02));
+    assert(near(s.percentile(99.5), 50.0, 0.02));
+    assert(s.maxMs() == 50.0);
+    assert(s.dropped == 10); // only the 50 ms frames exceed 1.5x 16.7 ms
+
+    // Bucket bounds are monotonic and contain their values.
+    for (uint64_t us : {0ull, 1ull, 63ull, 64ull, 65ull, 1000ull, 16667ull, 123456789ull}) {
+        int idx = FrameStats::bucketIndex(us);
+        assert(FrameStats::bucketValue(idx) >= us);
+        if (idx > 0) assert(FrameStats::bucketValue(idx - 1) < us);
+    }
+
+    FrameStats csv;
+    csv.keepSamples = true;
+    csv.record(10.0);
+    csv.record(12.5);
+    const char* path = "frame_stats_test.csv";
+    assert(csv.writeCsv(path));
+    std::ifstream f(path);
+    std::string line;
+    std::getline(f, line); assert(line == "frame,ms");
+    std::getline(f, line); assert(line == "0,10.000");
+    std::getline(f, line); assert(line == "1,12.500");
+    f.close();
+    std::remove(path);
+    return 0;
+}
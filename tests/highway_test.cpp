@@ -0,0 +1,81 @@
+#include "../src/highway.hpp"
+#include <cassert>
+#include <cmath>
+
+static std::size_t bruteFirst(const std::vector<NoteEvent>& v, int64_t from) {
+    std::size_t i = 0;
+    while (i < v.size() && v[i].t_ms < from) ++i;
+    return i;
+}
+
+static std::size_t bruteLast(const std::vector<NoteEvent>& v, int64_t to) {
+    std::size_t i = 0;
+    while (i < v.size() && v[i].t_ms <= to) ++i;
+    return i;
+}
+
+int main() {
+    // Defaults keep the original highway: centred hit line, 0.9 widths per 4 s.
+    HighwayView v(1280, 1.0, 2000);
+    assert(std::abs(v.hitX - 640.0) < 1e-9);
+    assert(std::abs(v.pxPerMs - 1280 * 0.9 / 4000.0) < 1e-12);
+    assert(std::abs(v.x(4000.0) - (640.0 + 1152.0)) < 1e-9);
+    assert(std::abs(v.aheadMs - 640.0 / v.pxPerMs) < 1e-9);
+    assert(v.behindMs == 2000.0);
+
+    // A longer look-ahead moves the hit line left so it fits on screen...
+    HighwayView far(1280, 1.0, 3000);
+    assert(far.hitX < 640.0 && std::abs(far.x(3000.0) - 1280.0) < 1e-9);
+    // ...down to 10% of the width, beyond which it is cut short.
+    HighwayView cut(1280, 2.0, 10000);
+    assert(std::abs(cut.hitX - 128.0) < 1e-9 && cut.aheadMs < 10000.0);
+    assert(std::abs(cut.x(cut.aheadMs) - 1280.0) < 1e-9);
+    // Faster scrolling covers less time at the same hit line.
+    HighwayView fast(1280, 2.0, 500);
+    assert(fast.hitX == 640.0 && fast.aheadMs < v.aheadMs);
+    assert(v.depth(0.0) == 1.0 && v.depth(v.aheadMs) > 0.4 && v.depth(v.aheadMs) < 0.5);
+
+    // The visible range matches a brute-force scan whichever way time moves.
+    std::vector<NoteEvent> notes;
+    for (int i = 0; i < 2000; ++i) {
+        NoteEvent n{};
+        n.t_ms = i * 37 / 3; // some share a start time
+        notes.push_back(n);
+    }
+    std::vector<uint32_t> all;
+    for (uint32_t i = 0; i < notes.size(); ++i) all.push_back(i);
+    VisibleRange r;
+    auto check = [&](int64_t now, int64_t behind, int64_t ahead) {
+        r.update(notes, all, now - behind, now + ahead);
+        assert(r.first == bruteFirst(notes, now - behind));
+        assert(r.last == bruteLast(notes, now + ahead));
+    };
+    for (int64_t now = -3000; now < 30000; now += 16) check(now, 2000, 2222);
+    for (int64_t now = 30000; now > 0; now -= 7) check(now, 2000, 2222);   // rewinding
+    for (int64_t ahead = 500; ahead < 10000; ahead += 250) check(12000, 1000, ahead); // look-ahead changes
+    check(2000, 2000, 2222);    // seek back
+    check(24000, 2000, 2222);   // seek forward
+    check(100000, 2000, 2222);  // past the end
+    assert(r.first == r.last && r.last == notes.size());
+
+    // A sparser layer: positions count the layer's notes only.
+    std::vector<uint32_t> odd;
+    for (uint32_t i = 1; i < notes.size(); i += 2) odd.push_back(i);
+    r.update(notes, odd, 10000, 12000);
+    assert(notes[odd[r.first]].t_ms >= 10000 && notes[odd[r.first - 1]].t_ms < 10000);
+    assert(notes[odd[r.last - 1]].t_ms <= 12000 && notes[odd[r.last]].t_ms > 12000);
+    r.update(notes, all, 10000, 12000); // and back
+    assert(r.first == bruteFirst(notes, 10000) && r.last == bruteLast(notes, 12000));
+
+    // A chart that shrinks under the cursor.
+    notes.resize(10);
+    all.resize(10);
+    check(24000, 2000, 2222);
+    assert(r.first == 10);
+    check(0, 2000, 2222);
+    notes.clear();
+    all.clear();
+    check(0, 2000, 2222);
+    assert(r.first == 0 && r.last == 0);
+    return 0;
+}
@@ -0,0 +1,46 @@
+#define ROCKTRAINER_NO_MAIN
+#include "../src/main.cpp"
+#include <cassert>
+
+int main() {
+    App app{};
+    // First frame always renders.
+    assert(needsRedraw(app));
+    app.redraw = false;
+    assert(!needsRedraw(app));
+
+    // Input invalidates the menu.
+    SDL_Event e{};
+    e.type = SDL_KEYDOWN;
+    e.key.keysym.sym = SDLK_DOWN;
+    handleEvent(app, e);
+    assert(app.menuIndex == 1);
+    assert(needsRedraw(app));
+    app.redraw = false;
+
+    // Lost render targets invalidate the cached layers and the frame.
+    app.rs.layersValid = true;
+    e.type = SDL_RENDER_TARGETS_RESET;
+    handleEvent(app, e);
+    assert(!app.rs.layersValid && needsRedraw(app));
+    app.redraw = false;
+
+    // The tuner only redraws when the detected pitch changes.
+    app.state = AppState::Tuner;
+    g_detectedHz.store(110.0f, std::memory_order_relaxed);
+    assert(needsRedraw(app));
+    app.redraw = false;
+    assert(!needsRedraw(app));
+    g_detectedHz.store(110.5f, std::memory_order_relaxed);
+    assert(needsRedraw(app));
+    app.redraw = false;
+
+    // Play and the F3 overlay animate continuously.
+    app.state = AppState::Title;
+    app.showFrameGraph = true;
+    assert(needsRedraw(app));
+    app.showFrameGraph = false;
+    app.state = AppState::Play;
+    assert(needsRedraw(app));
+    return 0;
+}
@@ -0,0 +1,47 @@
+#include "../src/note_table.hpp"
+#include <cassert>
+#include <cmath>
+
+static double midiHz(int midi) { return 440.0 * std::pow(2.0, (midi - 69) / 12.0); }
+
+int main() {
+    // Standard tunings, lowest string first.
+    static_assert(Guitar6::standardTuning() == std::array<int, 6>{40, 45, 50, 55, 59, 64});
+    static_assert(Guitar7::standardTuning()[0] == 35 && Guitar7::standardTuning()[6] == 64);
+    static_assert(Guitar8::standardTuning()[0] == 30);
+    static_assert(Bass4::standardTuning() == std::array<int, 4>{28, 33, 38, 43});
+    static_assert(Bass5::standardTuning()[0] == 23 && Bass5::standardTuning()[4] == 43);
+
+    // Chart string numbers (1 = highest) <-> indices (0 = lowest).
+    static_assert(Guitar6::indexOf(6) == 0 && Guitar6::indexOf(1) == 5);
+    static_assert(Bass4::indexOf(4) == 0 && Bass4::stringOf(3) == 1);
+    static_assert(Guitar8::stringOf(0) == 8);
+
+    // Dispatch by string count, six for anything unsupported.
+    for (int n : {4, 5, 6, 7, 8}) assert(withInstrument(n, [](auto p) { return p.kStrings; }) == n);
+    assert(withInstrument(3, [](auto p) { return p.kStrings; }) == 6);
+    assert(withInstrument(12, [](auto p) { return p.kStrings; }) == 6);
+
+    // Named instruments.
+    int strings = 0;
+    std::array<int, kMaxStrings> tuning{};
+    assert(instrumentByName("bass", strings, tuning) && strings == 4 && tuning[0] == 28 && tuning[4] == 0);
+    assert(instrumentByName("guitar7", strings, tuning) && strings == 7 && tuning[0] == 35);
+    assert(instrumentByName("baritone", strings, tuning) && strings == 6);
+    assert(tuning[0] == 35 && tuning[4] == 54 && tuning[5] == 59); // B standard
+    assert(!instrumentByName("banjo", strings, tuning));
+
+    // Note tables follow the profile: a bass places E1 on its lowest string,
+    // and a 7-string's low B has a position a six-string doesn't.
+    BasicNoteTable<Bass4> bass;
+    auto d = bass.classify(midiHz(28));
+    assert(d && d->midi == 28 && d->stringIdx == 0 && d->fret == 0);
+    assert(bass.candidates(43)->count == 4);
+    BasicNoteTable<Guitar7> seven;
+    d = seven.classify(midiHz(35));
+    assert(d && d->stringIdx == 0 && d->fret == 0);
+    assert(!NoteTable{}.candidates(35)->count);
+    assert(seven.candidates(59)->count == 6 && seven.candidates(59)->pos[0].fret == 24);
+    static_assert(sizeof(BasicNoteTable<Bass4>::Entry) < sizeof(BasicNoteTable<Guitar8>::Entry));
+    return 0;
+}
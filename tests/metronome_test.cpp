@@ -0,0 +1,108 @@
+#include "../src/metronome.hpp"
+#include <cassert>
+#include <vector>
+
+struct BeatAt { int64_t us; bool downbeat; };
+
+static std::vector<BeatAt> beats(const TempoMap& map, int64_t fromUs, int64_t toUs) {
+    std::vector<BeatAt> v;
+    map.forEachBeat(fromUs, toUs, [&](int64_t us, bool down) { v.push_back(BeatAt{us, down}); });
+    return v;
+}
+
+// Render `frames` frames of clicks in buffers of `block` frames, song time
+// songUs at frame 0 advancing at `rate`.
+static std::vector<float> render(const Metronome& m, const TempoMap& map, double sr, std::size_t frames,
+                                 std::size_t block, int64_t songUs, double rate) {
+    std::vector<float> out(frames * 2, 0.f);
+    for (std::size_t f = 0; f < frames; f += block) {
+        std::size_t n = std::min(block, frames - f);
+        int64_t t = songUs + (int64_t)std::llround((double)f * 1e6 / sr * rate);
+        m.mix(out.data() + f * 2, n, 2, sr, map, t, rate);
+    }
+    return out;
+}
+
+int main() {
+    Chart chart;
+    chart.bpm = 120.0;
+
+    // Constant tempo: a beat every 500 ms, bars of four from 0, and the grid
+    // runs back before 0 for count-ins.
+    {
+        TempoMap map(chart);
+        auto b = beats(map, 0, 2000000);
+        assert(b.size() == 4);
+        assert(b[0].us == 0 && b[0].downbeat);
+        assert(b[1].us == 500000 && !b[1].downbeat);
+        assert(b[3].us == 1500000 && !b[3].downbeat);
+        auto pre = beats(map, -2000000, 1);
+        assert(pre.size() == 5);
+        assert(pre[0].us == -2000000 && pre[0].downbeat);
+        assert(pre[2].us == -1000000 && !pre[2].downbeat);
+    }
+
+    // A change to 60 bpm in 3/4 at 2 s restarts the bar there.
+    chart.tempo.push_back(TempoChange{2000000 / 1000, 60.0, 3});
+    {
+        TempoMap map(chart);
+        auto b = beats(map, 1000000, 6000000);
+        assert(b.size() == 6);
+        assert(b[0].us == 1000000 && b[0].downbeat == false);
+        assert(b[1].us == 1500000);
+        assert(b[2].us == 2000000 && b[2].downbeat);
+        assert(b[3].us == 3000000 && !b[3].downbeat);
+        assert(b[4].us == 4000000 && !b[4].downbeat);
+        assert(b[5].us == 5000000 && b[5].downbeat);
+
+        // Metrical strength follows the same grid.
+        assert(map.strength(0) == 0);
+        assert(map.strength(500000) == 1 && map.strength(510000) == 1);
+        assert(map.strength(250000) == 2);
+        assert(map.strength(125000) == 3);
+        assert(map.strength(60000) == 4);
+        assert(map.strength(2000000) == 0);  // the change starts a bar
+        assert(map.strength(3000000) == 1 && map.strength(5000000) == 0);
+        assert(map.strength(2500000) == 2);
+        assert(map.strength(-2000000) == 0); // count-in bars
+    }
+    chart.tempo.clear();
+
+    const double sr = 48000.0;
+    Metronome m;
+    m.prepare(sr);
+    TempoMap map(chart);
+
+    // Each click starts at its beat's exact frame, whatever the buffer size,
+    // including clicks straddling buffer boundaries.
+    {
+        auto whole = render(m, map, sr, 48000, 48000, -100000, 1.0);
+        for (std::size_t block : {64u, 97u, 256u}) {
+            auto split = render(m, map, sr, 48000, block, -100000, 1.0);
+            assert(split == whole);
+        }
+        // Beat 0 (accent) at frame 4800, beat 1 at 4800 + 24000.
+        for (std::size_t i = 0; i < 4800 * 2; ++i) assert(whole[i] == 0.f);
+        for (std::size_t i = 0; i < m.accent.size(); ++i) {
+            assert(whole[(4800 + i) * 2] == m.accent[i]);
+            assert(whole[(4800 + i) * 2 + 1] == m.accent[i]);
+        }
+        for (std::size_t i = 0; i < m.beat.size(); ++i) assert(whole[(28800 + i) * 2] == m.beat[i]);
+        assert(whole[(28800 + m.beat.size()) * 2] == 0.f);
+    }
+
+    // At half speed beats are twice as far apart in the output, and the
+    // clicks themselves keep their length.
+    {
+        auto slow = render(m, map, sr, 96000, 128, 0, 0.5);
+        for (std::size_t i = 0; i < m.beat.size(); ++i) assert(slow[(48000 + i) * 2] == m.beat[i]);
+        for (std::size_t i = m.accent.size(); i < 48000; ++i) assert(slow[i * 2] == 0.f);
+    }
+
+    // Paused (rate 0): silence.
+    {
+        auto paused = render(m, map, sr, 4800, 256, 0, 0.0);
+        for (float s : paused) assert(s == 0.f);
+    }
+    return 0;
+}
@@ -26,5 +26,42 @@ int main() {
     assert(n.fret == 0);
     assert(n.len_ms == 500); // 1 beat at 120 BPM
     assert(c.tuning[0] == 40);
+    assert(c.tempo.empty());
+
+    // Measures can change tempo and time signature; later measures start
+    // after the beats of the changed ones.
+    std::ofstream g(tmp);
+    g << R"({
+  "meta": {"bpm": 120},
+  "measures": [
+    {"notes": [{"beat": 0.0, "string": 1, "fret": 0}]},
+    {"bpm": 60, "beats": 3, "notes": [{"beat": 1.0, "string": 2, "fret": 1, "sustain": 0.5}]},
+    {"notes": [{"beat": 0.0, "string": 3, "fret": 2}]}
+  ]
+})";
+    g.close();
+    auto changed = loadChartMss(tmp);
+    fs::remove(tmp);
+    assert(changed && changed->notes.size() == 3);
+    assert(changed->notes[1].t_ms == 3000);
+    assert(changed->notes[1].len_ms == 500);
+    assert(changed->notes[2].t_ms == 5000);
+    assert(changed->tempo.size() == 1);
+    assert(changed->tempo[0].t_ms == 2000 && changed->tempo[0].bpm == 60.0 && changed->tempo[0].beatsPerBar == 3);
+    assert(changed->strings == 6);
+
+    // An instrument name sets the string count and its standard tuning; an
+    // explicit tuning's length overrides the count.
+    std::ofstream h(tmp);
+    h << R"({"meta": {"instrument": "bass5"}, "measures": []})";
+    h.close();
+    auto bass = loadChartMss(tmp);
+    assert(bass && bass->strings == 5 && bass->tuning[0] == 23 && bass->tuning[4] == 43);
+    std::ofstream k(tmp);
+    k << R"({"meta": {"tuning": [35, 40, 45, 50, 55, 59, 64]}, "measures": []})";
+    k.close();
+    auto seven = loadChartMss(tmp);
+    fs::remove(tmp);
+    assert(seven && seven->strings == 7 && seven->tuning[6] == 64);
     return 0;
 }
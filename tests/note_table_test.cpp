@@ -0,0 +1,43 @@
+#include "../src/note_table.hpp"
+#include <cassert>
+#include <cmath>
+
+int main() {
+    // fastLog2 tracks std::log2 across the guitar range and beyond.
+    for (double x = 1e-3; x < 1e5; x *= 1.0037) assert(std::abs(fastLog2(x) - std::log2(x)) < 5e-6);
+    assert(fastLog2(1.0) == 0.0);
+    assert(fastLog2(1024.0) == 10.0);
+
+    // Classification matches the exact math: nearest note and cents.
+    NoteTable table; // six strings, standard tuning
+    for (double hz = 70.0; hz < 1400.0; hz *= 1.0011) {
+        double midiF = 69.0 + 12.0 * std::log2(hz / 440.0);
+        if (std::abs(midiF - std::floor(midiF) - 0.5) < 1e-4) continue; // rounding boundary
+        auto d = table.classify(hz);
+        assert(d);
+        assert(d->midi == (int)std::lround(midiF));
+        assert(std::abs(d->cents - 100.0 * (midiF - d->midi)) < 0.01);
+    }
+    assert(!table.classify(0.0));
+    assert(!table.classify(-5.0));
+
+    // E4 can be played on all six strings; the default is the lowest string.
+    const NoteTable::Entry* e4 = table.candidates(64);
+    assert(e4 && e4->count == 6);
+    assert(e4->pos[0].stringIdx == 0 && e4->pos[0].fret == 24);
+    assert(e4->pos[5].stringIdx == 5 && e4->pos[5].fret == 0);
+    auto d = table.classify(329.63);
+    assert(d && d->midi == 64 && d->stringIdx == 0 && d->fret == 24);
+
+    // Below the lowest open string there is no position.
+    d = table.classify(41.2); // E1
+    assert(d && d->midi == 28 && d->stringIdx == -1 && d->fret == -1);
+
+    // Rebuilding for drop D gives the low D a position on string 0.
+    const int dropD[] = {38, 45, 50, 55, 59, 64};
+    table.build(dropD);
+    d = table.classify(73.42);
+    assert(d && d->midi == 38 && d->stringIdx == 0 && d->fret == 0);
+    assert(table.candidates(39)->count == 1);
+    return 0;
+}
@@ -23,5 +23,59 @@ int main() {
     assert(app2.stats.misses == 1);
     assert(app2.stats.combo == 0);
     assert(app2.stats.accuracy == 0.0f);
+
+    // The same pitch played where the chart puts it (B string, 5th fret)
+    // counts, not just on the lowest string that has it.
+    App app3{};
+    n.str = 2; n.fret = 5;
+    app3.chart.notes.push_back(n);
+    g_detectedHz.store(midiToHz(kStringOpenMidi[5]), std::memory_order_relaxed);
+    updateGameplay(app3, 0);
+    assert(app3.stats.hits == 1);
+
+    // A bass chart is judged with the bass profile: the open E string is
+    // string 4 and E1 is playable.
+    App app4{};
+    app4.chart.strings = 4;
+    app4.chart.tuning = {28, 33, 38, 43};
+    n.str = 4; n.fret = 0;
+    app4.chart.notes.push_back(n);
+    setInstrument(app4.chart);
+    g_detectedHz.store(midiToHz(28), std::memory_order_relaxed);
+    updateGameplay(app4, 0);
+    assert(app4.stats.hits == 1);
+    assert(g_stringNames[0] == "E1" && g_stringNames[4].empty());
+    setInstrument(Chart{});
+
+    // On an easier layer, notes it leaves out are neither judged nor missed;
+    // switching level mid-song carries on from the next note of the new one.
+    App app5{};
+    n.str = 6; n.fret = 0; n.len_ms = 100;
+    for (int64_t t : {1000, 1250, 1500, 1750, 2000}) { n.t_ms = t; app5.chart.notes.push_back(n); }
+    app5.compiled.sync(app5.chart);
+    setDifficulty(app5.stats, app5.compiled, 0); // beats only: 1000, 1500, 2000
+    g_detectedHz.store(midiToHz(kStringOpenMidi[0]), std::memory_order_relaxed);
+    judgeNotes(app5.stats, app5.compiled, 1000, g_detectedHz.load());
+    g_detectedHz.store(0.0f, std::memory_order_relaxed);
+    judgeNotes(app5.stats, app5.compiled, 1400, 0.0f);
+    assert(app5.stats.hits == 1 && app5.stats.misses == 0); // 1250 isn't on Easy
+    setDifficulty(app5.stats, app5.compiled, kDifficultyLevels - 1);
+    assert(app5.stats.nextNote == 2); // the 1500 note of the full chart
+    judgeNotes(app5.stats, app5.compiled, 2200, 0.0f);
+    assert(app5.stats.hits == 1 && app5.stats.misses == 3);
+
+    // PageUp/PageDown step from the level being judged, not the setting:
+    // after adaptive mode has dropped to Easy, PageDown stays on Easy.
+    App app6{};
+    app6.settings.difficulty = kDifficultyLevels - 1;
+    app6.stats.level = 0;
+    SDL_Event key{};
+    key.type = SDL_KEYDOWN;
+    key.key.keysym.sym = SDLK_PAGEDOWN;
+    updatePlay(app6, key);
+    assert(app6.settings.difficulty == 0 && app6.sim.level.load() == 0);
+    key.key.keysym.sym = SDLK_PAGEUP;
+    updatePlay(app6, key);
+    assert(app6.settings.difficulty == 1 && app6.sim.level.load() == 1);
     return 0;
 }
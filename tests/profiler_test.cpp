@@ -0,0 +1,60 @@
+#include "../src/profiler.hpp"
+#include <cassert>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <cstring>
+
+static void work() {
+    RT_PROFILE_SCOPE("work");
+    volatile int x = 0;
+    for (int i = 0; i < 10000; ++i) x = x + i;
+}
+
+int main() {
+    Profiler& p = Profiler::instance();
+
+    // Disabled: nothing is recorded.
+    work();
+    std::vector<PhaseTime> phases;
+    p.summarize(0, UINT64_MAX, phases);
+    assert(phases.empty());
+
+    p.enabled.store(true);
+    uint64_t from = Profiler::nowNs();
+    work();
+    work();
+    std::thread t([]{
+        Profiler::instance().setThreadName("worker");
+        work();
+    });
+    t.join();
+    // A ring registered up front is used as is; the thread adds none.
+    ProfileRing* rt = p.addRing("audio");
+    std::size_t ringCount = p.rings.size();
+    std::thread a([rt]{
+        Profiler::useRing(rt);
+        work();
+    });
+    a.join();
+    assert(p.rings.size() == ringCount && rt->head.load() == 1);
+    p.summarize(from, UINT64_MAX, phases);
+    assert(phases.size() == 1);
+    assert(std::strcmp(phases[0].name, "work") == 0);
+    assert(phases[0].ms > 0.0);
+
+    const char* path = "profiler_test_trace.json";
+    assert(p.writeChromeTrace(path));
+    std::ifstream f(path);
+    std::stringstream ss; ss << f.rdbuf();
+    std::string trace = ss.str();
+    assert(trace.find("\"traceEvents\"") != std::string::npos);
+    assert(trace.find("\"worker\"") != std::string::npos);
+    assert(trace.find("\"audio\"") != std::string::npos);
+    std::size_t count = 0;
+    for (std::size_t pos = 0; (pos = trace.find("\"ph\":\"X\"", pos)) != std::string::npos; ++pos) ++count;
+    assert(count == 4);
+    f.close();
+    std::remove(path);
+    return 0;
+}
@@ -0,0 +1,146 @@
+#define ROCKTRAINER_NO_MAIN
+#include "../src/main.cpp"
+#include <cassert>
+
+static bool sameInput(const TickInput& a, const TickInput& b) {
+    return a.playing == b.playing && a.rate == b.rate && a.level == b.level && a.adaptive == b.adaptive &&
+           a.latencyOffsetMs == b.latencyOffsetMs && a.audioOffsetMs == b.audioOffsetMs && a.hz == b.hz &&
+           a.centroidHz == b.centroidHz && a.detectedAtUs == b.detectedAtUs && a.hasTrack == b.hasTrack &&
+           a.trackUs == b.trackUs;
+}
+
+int main() {
+    const std::string path = (fs::temp_directory_path() / "rocktrainer_session_test.rtlog").string();
+
+    // Varints and zigzag round trip, small magnitudes in one byte.
+    for (int64_t v : std::initializer_list<int64_t>{0, 1, -1, 63, -64, 64, 1000000, -123456789012, INT64_MAX, INT64_MIN}) {
+        uint8_t buf[10];
+        uint8_t* end = SessionLog::putVarint(buf, SessionLog::zigzag(v));
+        SessionLog::Reader r{buf, end};
+        assert(SessionLog::unzigzag(r.varint()) == v && r.ok && r.p == end);
+        if (v >= -64 && v <= 63) assert(end - buf == 1);
+    }
+    uint8_t cut[] = {0x80, 0x80};
+    SessionLog::Reader bad{cut, cut + 2};
+    bad.varint();
+    assert(!bad.ok);
+
+    // Inputs come back tick for tick: a jittery backing track, detector hops
+    // stamped a few ms before the tick that sees them, a rate change.
+    std::vector<TickInput> ins;
+    {
+        SessionWriter w;
+        assert(w.open(path, 42, "Codec"));
+        TickInput in;
+        in.hasTrack = true;
+        in.trackUs = -40000; // count-in
+        in.latencyOffsetMs = -12;
+        for (int64_t t = 0; t < 20000; ++t) {
+            int64_t tickUs = 5000000 + t * 1000;
+            if (t == 9000) in.rate = 0.75;
+            in.playing = t < 15000 || t >= 16000;
+            if (in.playing) in.trackUs += std::llround(1000 * in.rate);
+            if (t % 64 == 0) in.trackUs += (t / 64) % 3 - 1; // output clock jitter
+            if (t % 6 == 0) {
+                in.hz = t % 300 < 100 ? 110.0f + (float)(t % 7) : 0.0f;
+                in.centroidHz = 800.0f + (float)(t % 11);
+                in.detectedAtUs = tickUs - 2500 - t % 5;
+            }
+            in.level = t == 100 ? 1 : -1;
+            w.record(in, tickUs);
+            ins.push_back(in);
+        }
+        w.close(7, 3);
+        assert(w.lostBytes.load() == 0);
+    }
+    SessionReplay log;
+    assert(log.load(path));
+    assert(log.hash == 42 && log.title == "Codec");
+    assert(log.ticks == ins.size() && log.hits == 7 && log.misses == 3);
+    // Replayed on another clock: detections keep their age.
+    for (std::size_t t = 0; t < ins.size(); ++t) {
+        TickInput out = log.next((int64_t)t * 1000);
+        TickInput want = ins[t];
+        want.detectedAtUs -= 5000000;
+        assert(sameInput(out, want));
+    }
+    assert(log.finished());
+    assert(!log.next(0).playing); // paused past the end
+    // A few bytes per detector hop and nothing for the ticks between.
+    assert(fs::file_size(path) < ins.size() * 3);
+
+    // A session judged live replays to the same score, level and song time.
+    Chart chart;
+    chart.title = "Replay";
+    NoteEvent n{};
+    n.str = 6; n.fret = 0; n.len_ms = 100;
+    for (int64_t t = 0; t < 24000; t += 250) { n.t_ms = t; chart.notes.push_back(n); }
+    setInstrument(chart);
+    const float lowE = (float)midiToHz(40);
+    ManualClock clock;
+    clock.setUs(1000000);
+    SessionWriter w;
+    assert(w.open(path, chartHash(chart), chart.title));
+    Simulation sim;
+    sim.recorder = &w;
+    sim.level.store(0);
+    sim.adaptive.store(true);
+    sim.reset(chart, true, clock);
+    g_latencyOffsetMs.store(0);
+    g_audioOffsetMs.store(4);
+    for (int64_t k = 0; k < 22000; ++k) {
+        int64_t song = sim.snapshot().songMs + 1;
+        // Mostly on time; every fifth note early by 30 ms, every ninth missed.
+        int64_t note = (song + 40) / 250;
+        int64_t off = note % 5 == 0 ? -30 : 0;
+        bool play = note % 9 != 4 && std::abs(song - (note * 250 + off)) < 10;
+        if (k % 6 == 0) {
+            g_detectedHz.store(play ? lowE : 0.0f, std::memory_order_relaxed);
+            g_detectedCentroidHz.store(play ? 900.0f : 0.0f, std::memory_order_relaxed);
+            g_detectedAtUs.store(clock.nowUs() - 2000, std::memory_order_relaxed);
+        }
+        if (k == 5000) sim.rate.store(0.9);
+        if (k == 12000) g_latencyOffsetMs.store(8);
+        if (k == 15000) sim.playing.store(false);
+        if (k == 15500) sim.playing.store(true);
+        clock.advanceUs(1000);
+        sim.advanceTo(clock.nowUs());
+    }
+    PlaySnapshot live = sim.snapshot();
+    w.close((uint64_t)live.stats.hits, (uint64_t)live.stats.misses);
+    g_detectedHz.store(0.0f);
+    g_detectedCentroidHz.store(0.0f);
+    g_detectedAtUs.store(0);
+    g_latencyOffsetMs.store(0);
+    g_audioOffsetMs.store(0);
+    sim.rate.store(1.0);
+    assert(live.stats.hits > 20 && live.stats.misses > 3);
+
+    assert(log.load(path) && log.hash == chartHash(chart));
+    GameplayStats again = replaySession(chart, log);
+    assert(again.hits == live.stats.hits && again.misses == live.stats.misses);
+    assert(again.combo == live.stats.combo && again.accuracy == live.stats.accuracy);
+    assert(again.level == live.stats.level && again.nextNote == live.stats.nextNote);
+    // Any number of times, and at another speed on a threaded simulation.
+    GameplayStats twice = replaySession(chart, log);
+    assert(twice.hits == again.hits && twice.misses == again.misses);
+    SteadyClock steady;
+    ScaledClock fast(steady, 200.0);
+    Simulation threaded;
+    threaded.replay = &log;
+    log.rewind();
+    threaded.start(chart, true, fast);
+    while (!threaded.replayDone.load()) std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    threaded.stop();
+    assert(threaded.snapshot().stats.hits == live.stats.hits);
+    assert(threaded.snapshot().songMs == live.songMs);
+
+    // Another chart doesn't match; a cut-short log doesn't load.
+    Chart other = chart;
+    other.notes[3].fret = 2;
+    assert(chartHash(other) != log.hash);
+    fs::resize_file(path, fs::file_size(path) - 2);
+    assert(!log.load(path));
+    fs::remove(path);
+    return 0;
+}
@@ -8,6 +8,14 @@ int main() {
     s.audioDeviceIndex = 3;
     s.bufferSize = 256;
     s.latencyOffset = 42;
+    s.audioOffsetMs = 27;
+    s.visualOffsetMs = -12;
+    s.metronome = true;
+    s.scrollSpeed = 1.5;
+    s.lookAheadMs = 3250;
+    s.difficulty = 1;
+    s.adaptiveDifficulty = true;
+    s.recordSessions = true;
     s.vsync = false;
     s.width = 800;
     s.height = 600;
@@ -30,6 +38,12 @@ int main() {
     assert(loaded.audioDeviceIndex == s.audioDeviceIndex);
     assert(loaded.bufferSize == s.bufferSize);
     assert(loaded.latencyOffset == s.latencyOffset);
+    assert(loaded.audioOffsetMs == s.audioOffsetMs);
+    assert(loaded.visualOffsetMs == s.visualOffsetMs);
+    assert(loaded.metronome);
+    assert(loaded.scrollSpeed == 1.5 && loaded.lookAheadMs == 3250);
+    assert(loaded.difficulty == 1 && loaded.adaptiveDifficulty);
+    assert(loaded.recordSessions);
     assert(loaded.vsync == s.vsync);
     assert(loaded.width == s.width);
     assert(loaded.height == s.height);
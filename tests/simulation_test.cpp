@@ -0,0 +1,163 @@
+#define ROCKTRAINER_NO_MAIN
+#include "../src/main.cpp"
+#include <cassert>
+
+int main() {
+    Chart chart;
+    NoteEvent n{};
+    n.t_ms = 50; n.str = 6; n.fret = 24; n.len_ms = 100;
+    chart.notes.push_back(n);
+    n.t_ms = 400;
+    chart.notes.push_back(n);
+    double hitHz = midiToHz(64);
+
+    // Stepped by hand: the first note is heard late in its window and still
+    // counts; the second is never played and misses once its window closes.
+    ManualClock clock;
+    Simulation sim;
+    sim.reset(chart, true, clock);
+    g_detectedHz.store(0.0f, std::memory_order_relaxed);
+    clock.advanceUs(120000);
+    sim.advanceTo(clock.nowUs());
+    assert(sim.snapshot().stats.hits == 0);
+    g_detectedHz.store((float)hitHz, std::memory_order_relaxed);
+    clock.advanceUs(1000);
+    sim.advanceTo(clock.nowUs());
+    assert(sim.snapshot().stats.hits == 1);
+    g_detectedHz.store(0.0f, std::memory_order_relaxed);
+    clock.advanceUs(400000);
+    sim.advanceTo(clock.nowUs());
+    PlaySnapshot snap = sim.snapshot();
+    assert(snap.songMs == 521);
+    assert(snap.clockUs == 521000);
+    assert(snap.stats.hits == 1);
+    assert(snap.stats.misses == 1);
+
+    // Rendering extrapolates from the snapshot to the clock's time.
+    clock.advanceUs(500);
+    assert(renderSongMs(sim.snapshot(), clock) == 521);
+    clock.advanceUs(2500);
+    assert(renderSongMs(snap, clock) == 524);
+
+    // Paused ticks don't advance song time.
+    sim.playing.store(false);
+    clock.advanceUs(10000);
+    sim.advanceTo(clock.nowUs());
+    assert(sim.snapshot().songMs == 521);
+    assert(renderSongMs(sim.snapshot(), clock) == 521);
+    assert(sim.song.load().rate == 0.0);
+
+    // A detection is judged at the song time its audio was captured: heard
+    // 30 ms before the tick that sees it, a late pluck still lands in the
+    // window that tick alone would already have closed.
+    clock.setUs(0);
+    sim.reset(chart, true, clock);
+    g_detectedHz.store(0.0f, std::memory_order_relaxed);
+    clock.advanceUs(150000);
+    sim.advanceTo(clock.nowUs());
+    assert(sim.snapshot().stats.misses == 0);
+    g_detectedHz.store((float)hitHz, std::memory_order_relaxed);
+    g_detectedAtUs.store(121000, std::memory_order_relaxed);
+    clock.advanceUs(1000);
+    sim.advanceTo(clock.nowUs());
+    assert(sim.snapshot().stats.hits == 1);
+    assert(sim.snapshot().stats.misses == 0);
+    // Stale stamps (a held value from long ago) are ignored.
+    clock.advanceUs(400000);
+    sim.advanceTo(clock.nowUs());
+    assert(sim.snapshot().stats.hits == 2);
+    g_detectedAtUs.store(0, std::memory_order_relaxed);
+
+    // At half speed song time advances half a tick per tick, the renderer
+    // extrapolates at the same rate and the hit window is +-50 song ms.
+    sim.rate.store(0.5);
+    clock.setUs(0);
+    sim.reset(chart, true, clock);
+    g_detectedHz.store(0.0f, std::memory_order_relaxed);
+    clock.advanceUs(200000);
+    sim.advanceTo(clock.nowUs());
+    assert(sim.snapshot().songMs == 100);
+    assert(sim.snapshot().stats.misses == 0);
+    // The audio callback's song anchor extrapolates at the same rate.
+    assert(sim.song.load().map(clock.nowUs() + 10000) == 105000);
+    clock.advanceUs(2000);
+    sim.advanceTo(clock.nowUs());
+    assert(sim.snapshot().stats.misses == 1);   // 51 ms late: outside +-50
+    clock.advanceUs(10000);
+    assert(renderSongMs(sim.snapshot(), clock) == 106);
+    sim.rate.store(1.0);
+
+    // With a backing track the song holds at 0 until its audio starts.
+    BackingTrack silent;
+    clock.setUs(0);
+    sim.reset(chart, true, clock);
+    sim.track = &silent;
+    clock.advanceUs(50000);
+    sim.advanceTo(clock.nowUs());
+    assert(sim.snapshot().songMs == 0);
+    sim.track = nullptr;
+
+    // Threaded on the real clock: judgement keeps running while the
+    // "renderer" is stalled.
+    SteadyClock steady;
+    g_detectedHz.store((float)hitHz, std::memory_order_relaxed);
+    sim.start(chart, true, steady);
+    std::this_thread::sleep_for(std::chrono::milliseconds(600));
+    snap = sim.snapshot();
+    sim.stop();
+    assert(snap.songMs >= 500);
+    assert(snap.stats.hits == 2);
+    assert(!sim.running.load());
+
+    // Replay at 100x on a threaded simulation judges the same as real time.
+    // Wall time isn't asserted (sanitizers and busy runners vary); the clock's
+    // scaling itself is covered by clock_test.
+    Chart longChart;
+    for (int i = 0; i < 100; ++i) {
+        n.t_ms = 200 + i * 250;
+        longChart.notes.push_back(n);
+    }
+    ScaledClock fast(steady, 100.0);
+    sim.start(longChart, true, fast);
+    while (sim.snapshot().songMs < 30000) std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    sim.stop();
+    assert(sim.snapshot().stats.hits == 100);
+
+    // Adaptive difficulty in the tick: played cleanly from Easy, the level
+    // steps up once per phrase (four bars of beats and eighths at 120 bpm),
+    // each time from the first note of the next phrase.
+    Chart song;
+    NoteEvent e{};
+    e.str = 6; e.fret = 0; e.len_ms = 100;
+    for (int64_t t = 0; t < 24000; t += 250) { e.t_ms = t; song.notes.push_back(e); }
+    const float lowE = (float)midiToHz(40);
+    clock.setUs(0);
+    sim.level.store(0);
+    sim.adaptive.store(true);
+    sim.reset(song, true, clock);
+    auto playTo = [&](int64_t songMs) {
+        while (sim.snapshot().songMs < songMs) {
+            int64_t next = sim.snapshot().songMs + 1;
+            g_detectedHz.store(next % 250 < 3 ? lowE : 0.0f, std::memory_order_relaxed);
+            clock.advanceUs(1000);
+            sim.advanceTo(clock.nowUs());
+        }
+    };
+    playTo(7400);
+    assert(sim.snapshot().stats.level == 0 && sim.snapshot().stats.hits == 15);
+    playTo(7600);  // the phrase's last note is judged: decide for the next one
+    assert(sim.snapshot().stats.level == 1 && sim.snapshot().stats.hits == 16);
+    playTo(8300);  // Medium from 8 s: eighths too
+    assert(sim.snapshot().stats.hits == 16 + 2);
+    playTo(15900);
+    assert(sim.snapshot().stats.hits == 16 + 32 && sim.snapshot().stats.misses == 0);
+    assert(sim.snapshot().stats.level == 2);
+    // A manual change still wins, and adaptation carries on from there.
+    sim.level.store(0);
+    playTo(16300);
+    assert(sim.snapshot().stats.level == 0);
+    sim.adaptive.store(false);
+    sim.level.store(kDifficultyLevels - 1);
+    g_detectedHz.store(0.0f, std::memory_order_relaxed);
+    return 0;
+}
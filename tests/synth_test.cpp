@@ -0,0 +1,38 @@
+#include "../src/synth.hpp"
+#include "../src/pitch_detect.hpp"
+#include <cassert>
+#include <cmath>
+
+static double centsOff(double hz, double ref) { return 1200.0 * std::log2(hz / ref); }
+
+int main() {
+    // Open A string (string 5, MIDI 45 = 110 Hz) for one second.
+    Chart c;
+    NoteEvent n{};
+    n.t_ms = 0; n.str = 5; n.fret = 0; n.len_ms = 1000;
+    c.notes.push_back(n);
+    SynthOptions opt;
+    std::vector<float> pcm = renderChartAudio(c, opt);
+    assert(pcm.size() == (std::size_t)(1.5 * opt.sampleRate));
+
+    float peak = 0.f;
+    for (float v : pcm) peak = std::max(peak, std::abs(v));
+    assert(peak > 0.05f && peak < 1.0f);
+
+    NsdfPitchDetector det(2048, (float)opt.sampleRate);
+    float hz = 0.f;
+    for (std::size_t i = 0; i + 512 <= 24000; i += 512) hz = det.process(&pcm[i], 512);
+    assert(std::abs(centsOff(hz, 110.0)) < 10.0);
+
+    // Fret 7 on the same string is E3 (164.8 Hz); the string is re-plucked.
+    n.t_ms = 1000; n.fret = 7;
+    c.notes.push_back(n);
+    pcm = renderChartAudio(c, opt);
+    NsdfPitchDetector det2(2048, (float)opt.sampleRate);
+    for (std::size_t i = 48000 + 9600; i + 512 <= 48000 + 24000; i += 512) hz = det2.process(&pcm[i], 512);
+    assert(std::abs(centsOff(hz, 164.81)) < 10.0);
+
+    // Same seed, same output.
+    assert(renderChartAudio(c, opt) == pcm);
+    return 0;
+}
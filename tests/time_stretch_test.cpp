@@ -0,0 +1,90 @@
+#include "../src/time_stretch.hpp"
+#include <cassert>
+#include <cmath>
+#include <numbers>
+#include <vector>
+
+// Stretch `seconds` of a stereo sine at `rate`; returns the output.
+static std::vector<float> stretchSine(double hz, double seconds, double rate, std::vector<double>* positions = nullptr) {
+    const double sr = 48000.0;
+    std::size_t frames = (std::size_t)(seconds * sr);
+    std::vector<float> in(2 * frames);
+    for (std::size_t i = 0; i < frames; ++i)
+        in[2 * i] = in[2 * i + 1] = 0.5f * (float)std::sin(2.0 * std::numbers::pi * hz * (double)i / sr);
+    TimeStretcher ts;
+    ts.reset(sr, 0);
+    std::vector<float> out, hop(2 * (std::size_t)ts.hop);
+    std::size_t fed = 0;
+    for (;;) {
+        while (ts.needed() > 0 && fed < frames) {
+            std::size_t n = std::min<std::size_t>(1024, frames - fed);
+            ts.push(&in[2 * fed], n);
+            fed += n;
+        }
+        double at = 0.0;
+        int n = ts.process(hop.data(), rate, at);
+        if (n == 0) break;
+        if (positions) positions->push_back(at);
+        out.insert(out.end(), hop.begin(), hop.begin() + 2 * n);
+    }
+    return out;
+}
+
+// Frequency from rising zero crossings of the left channel over [from, to).
+static double zeroCrossHz(const std::vector<float>& x, std::size_t from, std::size_t to) {
+    int crossings = 0;
+    std::size_t first = 0, last = 0;
+    for (std::size_t i = from + 1; i < to; ++i) {
+        if (x[2 * (i - 1)] < 0.f && x[2 * i] >= 0.f) {
+            if (crossings == 0) first = i;
+            last = i;
+            ++crossings;
+        }
+    }
+    return (crossings - 1) * 48000.0 / (double)(last - first);
+}
+
+static double rms(const std::vector<float>& x, std::size_t from, std::size_t to) {
+    double s = 0.0;
+    for (std::size_t i = from; i < to; ++i) s += (double)x[2 * i] * x[2 * i];
+    return std::sqrt(s / (double)(to - from));
+}
+
+int main() {
+    for (double rate : {0.5, 0.75, 0.9}) {
+        std::vector<double> pos;
+        std::vector<float> out = stretchSine(220.0, 2.0, rate, &pos);
+        std::size_t frames = out.size() / 2;
+        // Duration scales by 1/rate (less the final frame of look-ahead).
+        double expect = 2.0 * 48000.0 / rate;
+        assert(std::abs((double)frames - expect) < 0.04 * expect);
+        // Pitch is unchanged and joins are in phase: no beating or dips.
+        assert(std::abs(zeroCrossHz(out, 4800, frames - 4800) - 220.0) < 2.0);
+        double ref = 0.5 / std::sqrt(2.0);
+        for (std::size_t w = 4800; w + 2400 < frames - 4800; w += 2400)
+            assert(std::abs(rms(out, w, w + 2400) / ref - 1.0) < 0.1);
+        // Each hop's track position advances by hop * rate.
+        for (std::size_t i = 1; i < pos.size(); ++i) assert(std::abs(pos[i] - pos[i - 1] - 768 * rate) < 1e-6);
+    }
+
+    // Fed exactly what needed() asks for, every read stays inside the buffer,
+    // even when a fractional position rounds up and the search (on a rising
+    // ramp, which always prefers the latest candidate) ends at +tolerance.
+    for (double rate : {0.55, 0.65, 0.75, 0.85, 0.95}) {
+        TimeStretcher ts;
+        ts.reset(48000.0, 0);
+        std::vector<float> hop(2 * (std::size_t)ts.hop), chunk;
+        int64_t fed = 0;
+        for (int k = 0; k < 200; ++k) {
+            chunk.clear();
+            for (int64_t i = 0; i < ts.needed(); ++i, ++fed)
+                chunk.insert(chunk.end(), 2, (float)fed * 1e-5f);
+            ts.push(chunk.data(), chunk.size() / 2);
+            assert(ts.needed() == 0);
+            assert(ts.bestStart() + ts.frameLen <= ts.inEnd());
+            double at = 0.0;
+            assert(ts.process(hop.data(), rate, at) == ts.hop);
+        }
+    }
+    return 0;
+}
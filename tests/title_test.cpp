@@ -7,7 +7,7 @@ int main() {
     SDL_Event e{};
 
     int itemH = 60;
-    int menuCount = 5; // number of items in kMenu
+    int menuCount = 6; // number of items in kMenu
     int startY = app.rs.h/2 - menuCount*itemH/2;
 
     // Mouse motion should update highlighted menu item